@@ -0,0 +1,426 @@
+#define _POSIX_C_SOURCE 200809L
+#include "game.h"
+#include "board.h"
+#include "io.h"
+#include "archive.h"
+#include "error-codes.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#define MAX_THREADS 256
+#define MAX_ARCHIVE_MOVES 65535
+#define INITIAL_FILES 1024
+#define INITIAL_REPORT 256
+
+/**
+ * One file to adjudicate and what was found in it. Each file is handled by a single thread,
+ * so its report needs no locking.
+ */
+typedef struct {
+    char* path;
+    unsigned long games;
+    unsigned long mismatches;
+    char* report;
+    size_t report_length;
+    size_t report_capacity;
+} job;
+
+/**
+ * The files shared by the worker threads. next is the first file no thread has taken yet.
+ */
+typedef struct {
+    job* jobs;
+    size_t count;
+    size_t capacity;
+    size_t next;
+} job_list;
+
+/**
+ * Prints out the error message to the console if command line args are not correct.
+ */
+static void arg_error();
+
+/**
+ * Adds a .gmk or .gmb file to the list, or every such file under a directory, in name order.
+ * @param list The list of files.
+ * @param path The file or directory.
+ * @param explicit True if the path was named on the command line, so it is added whatever its extension.
+ */
+static void add_path( job_list* list, const char* path, bool explicit );
+
+/**
+ * Returns whether a path ends with the given extension.
+ * @param path The path.
+ * @param extension The extension, including the dot.
+ * @return True if the path ends with the extension.
+ */
+static bool has_extension( const char* path, const char* extension );
+
+/**
+ * Compares two strings through pointers to them, for qsort.
+ * @param a Pointer to the first string.
+ * @param b Pointer to the second string.
+ * @return The strcmp order of the strings.
+ */
+static int compare_names( const void* a, const void* b );
+
+/**
+ * Takes files from the list until none is left and adjudicates them.
+ * @param arg The shared job_list.
+ * @return NULL.
+ */
+static void* worker( void* arg );
+
+/**
+ * Adjudicates every game of one file, a saved game or an archive. A file, or a game of an archive,
+ * that cannot be read is reported as unreadable with its error code, and the others are still checked.
+ * @param j The file.
+ * @param moves Array of at least MAX_ARCHIVE_MOVES moves the thread can use to decode archived games.
+ */
+static void adjudicate_file( job* j, move* moves );
+
+/**
+ * Replays one game with game_make_move and compares the result with the recorded state and winner.
+ * A mismatch is added to the report of the file.
+ * @param j The file the game belongs to.
+ * @param number The number of the game in the file, starting at 1.
+ * @param size The board size.
+ * @param type The game type.
+ * @param state The recorded game state.
+ * @param winner The recorded winner.
+ * @param moves The recorded moves.
+ * @param num_moves The number of recorded moves.
+ */
+static void adjudicate_game( job* j, unsigned long number, unsigned char size, unsigned char type, unsigned char state,
+                             unsigned char winner, const move* moves, size_t num_moves );
+
+/**
+ * Adds one CSV line to the report of a file.
+ * @param j The file.
+ * @param format The printf format of the line, without the file name and the newline.
+ */
+static void report( job* j, const char* format, ... );
+
+/**
+ * Replays saved games and archives without printing the board, and lists the games whose recorded
+ * state or winner does not match the replay as CSV on standard output. A summary with the speed in
+ * games per second is printed on standard error.
+ * Use -threads followed by a number to spread the files over that many threads (one per core by default).
+ * Use -o followed by a file name to write the CSV to that file instead.
+ * @param argc The total number of arguments.
+ * @param argv[] Array of arguments
+ * return 0 if every game matches, 1 if there are mismatches.
+ */
+int main( int argc, char *argv[] ) {
+    long threads = sysconf( _SC_NPROCESSORS_ONLN );
+    FILE* out = stdout;
+
+    int i = 1;
+    for ( ; i < argc && argv[i][0] == '-'; i++ ) {
+        if ( i + 1 >= argc ) {
+            arg_error();
+        } else if ( strcmp( argv[i], "-threads" ) == 0 ) {
+            threads = atoi( argv[++i] );
+            if ( threads <= 0 || threads > MAX_THREADS ) {
+                arg_error();
+            }
+        } else if ( strcmp( argv[i], "-o" ) == 0 ) {
+            out = fopen( argv[++i], "w" );
+            if ( out == NULL ) {
+                exit( FILE_OUTPUT_ERR );
+            }
+        } else {
+            arg_error();
+        }
+    }
+    if ( i == argc ) {
+        arg_error();
+    }
+    if ( threads < 1 ) {
+        threads = 1;
+    } else if ( threads > MAX_THREADS ) {
+        threads = MAX_THREADS;
+    }
+
+    job_list list = { NULL, 0, 0, 0 };
+    for ( ; i < argc; i++ ) {
+        add_path( &list, argv[i], true );
+    }
+    if ( ( size_t )threads > list.count ) {
+        threads = list.count > 0 ? list.count : 1;
+    }
+
+    struct timespec start;
+    struct timespec end;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    pthread_t pool[MAX_THREADS];
+    for ( int t = 0; t < threads; t++ ) {
+        if ( pthread_create( &pool[t], NULL, worker, &list ) != 0 ) {
+            fprintf(stderr, "ERROR: Failed to start thread\n");
+            exit(1);
+        }
+    }
+    for ( int t = 0; t < threads; t++ ) {
+        pthread_join( pool[t], NULL );
+    }
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    double seconds = ( end.tv_sec - start.tv_sec ) + ( end.tv_nsec - start.tv_nsec ) / 1e9;
+
+    //Reports in the order the files were listed, whichever thread finished first
+    unsigned long games = 0;
+    unsigned long mismatches = 0;
+    fprintf( out, "file,game,move,reason,recorded_state,recorded_winner,replayed_state,replayed_winner\n" );
+    for ( size_t f = 0; f < list.count; f++ ) {
+        if ( list.jobs[f].report_length > 0 ) {
+            fwrite( list.jobs[f].report, 1, list.jobs[f].report_length, out );
+        }
+        games += list.jobs[f].games;
+        mismatches += list.jobs[f].mismatches;
+        free( list.jobs[f].report );
+        free( list.jobs[f].path );
+    }
+    free( list.jobs );
+    if ( out != stdout && fclose( out ) != 0 ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    fprintf( stderr, "%lu games in %zu files, %lu mismatches, %.3f s, %.0f games/sec with %ld threads\n",
+             games, list.count, mismatches, seconds, seconds > 0 ? games / seconds : 0.0, threads );
+    return mismatches > 0 ? 1 : 0;
+}
+
+static void arg_error() {
+    printf( "usage: ./adjudicate [-threads <count>] [-o <mismatches.csv>] <saved-match.gmk|archive.gmb|directory>...\n" );
+    exit( ARGUMENT_ERR );
+}
+
+static void add_path( job_list* list, const char* path, bool explicit )
+{
+    struct stat info;
+    if ( stat( path, &info ) != 0 ) {
+        if ( explicit ) {
+            exit( FILE_INPUT_ERR );
+        }
+        return;
+    }
+
+    if ( S_ISDIR( info.st_mode ) ) {
+        DIR* dir = opendir( path );
+        if ( dir == NULL ) {
+            exit( FILE_INPUT_ERR );
+        }
+        //Read every name first so the directory is walked in a stable order
+        size_t count = 0;
+        size_t capacity = INITIAL_FILES;
+        char** names = ( char ** )malloc( capacity * sizeof( char * ) );
+        if (names == NULL) {
+            fprintf(stderr, "ERROR: Failed to allocate memory\n");
+            exit(1);
+        }
+        struct dirent* entry;
+        while ( ( entry = readdir( dir ) ) != NULL ) {
+            if ( strcmp( entry->d_name, "." ) == 0 || strcmp( entry->d_name, ".." ) == 0 ) {
+                continue;
+            }
+            if ( count == capacity ) {
+                capacity = capacity * 2;
+                names = ( char ** )realloc( names, capacity * sizeof( char * ) );
+                if (names == NULL) {
+                    fprintf(stderr, "ERROR: Failed to allocate memory\n");
+                    exit(1);
+                }
+            }
+            names[count] = ( char * )malloc( strlen( path ) + strlen( entry->d_name ) + 2 );
+            if (names[count] == NULL) {
+                fprintf(stderr, "ERROR: Failed to allocate memory\n");
+                exit(1);
+            }
+            sprintf( names[count], "%s/%s", path, entry->d_name );
+            count++;
+        }
+        closedir( dir );
+        qsort( names, count, sizeof( char * ), compare_names );
+        for ( size_t i = 0; i < count; i++ ) {
+            add_path( list, names[i], false );
+            free( names[i] );
+        }
+        free( names );
+        return;
+    }
+
+    if ( !explicit && !has_extension( path, ".gmk" ) && !has_extension( path, ".gmb" ) ) {
+        return;
+    }
+    if ( list->count == list->capacity ) {
+        list->capacity = list->capacity ? list->capacity * 2 : INITIAL_FILES;
+        list->jobs = ( job * )realloc( list->jobs, list->capacity * sizeof( job ) );
+        if (list->jobs == NULL) {
+            fprintf(stderr, "ERROR: Failed to allocate memory\n");
+            exit(1);
+        }
+    }
+    job* j = &list->jobs[list->count++];
+    j->path = ( char * )malloc( strlen( path ) + 1 );
+    if (j->path == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    strcpy( j->path, path );
+    j->games = 0;
+    j->mismatches = 0;
+    j->report = NULL;
+    j->report_length = 0;
+    j->report_capacity = 0;
+}
+
+static bool has_extension( const char* path, const char* extension )
+{
+    size_t length = strlen( path );
+    size_t extension_length = strlen( extension );
+    return length >= extension_length && strcmp( path + length - extension_length, extension ) == 0;
+}
+
+static int compare_names( const void* a, const void* b )
+{
+    return strcmp( *( char * const * )a, *( char * const * )b );
+}
+
+static void* worker( void* arg )
+{
+    job_list* list = ( job_list * )arg;
+    move* moves = ( move * )malloc( MAX_ARCHIVE_MOVES * sizeof( move ) );
+    if (moves == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    size_t f;
+    while ( ( f = __atomic_fetch_add( &list->next, 1, __ATOMIC_RELAXED ) ) < list->count ) {
+        adjudicate_file( &list->jobs[f], moves );
+    }
+    free( moves );
+    return NULL;
+}
+
+static void adjudicate_file( job* j, move* moves )
+{
+    if ( has_extension( j->path, ".gmb" ) ) {
+        unsigned char status;
+        archive* a = archive_read( j->path, &status );
+        if ( a == NULL ) {
+            //The whole archive is unreadable, so there is no game number
+            j->games++;
+            j->mismatches++;
+            report( j, ",,unreadable (error %d),,,,", status );
+            return;
+        }
+        for ( uint32_t i = 0; i < a->count; i++ ) {
+            archive_game ag;
+            status = archive_game_at( a, i, &ag );
+            if ( status == SUCCESS && !board_size_valid( ag.size ) ) {
+                status = BOARD_SIZE_ERR;
+            }
+            for ( unsigned short m = 0; status == SUCCESS && m < ag.moves_count; m++ ) {
+                status = archive_move( &ag, m, &moves[m].x, &moves[m].y );
+            }
+            if ( status != SUCCESS ) {
+                j->games++;
+                j->mismatches++;
+                report( j, "%u,,unreadable (error %d),,,,", i + 1, status );
+                continue;
+            }
+            adjudicate_game( j, i + 1, ag.size, ag.type, ag.state, ag.winner, moves, ag.moves_count );
+        }
+        archive_close( a );
+    } else {
+        unsigned char status;
+        game* saved = game_load( j->path, &status );
+        if ( saved == NULL ) {
+            j->games++;
+            j->mismatches++;
+            report( j, "1,,unreadable (error %d),,,,", status );
+            return;
+        }
+        adjudicate_game( j, 1, saved->board->size, saved->type, saved->state, saved->winner,
+                         saved->moves, saved->moves_count );
+        game_delete( saved );
+    }
+}
+
+static void adjudicate_game( job* j, unsigned long number, unsigned char size, unsigned char type, unsigned char state,
+                             unsigned char winner, const move* moves, size_t num_moves )
+{
+    j->games++;
+    if ( type != GAME_FREESTYLE && type != GAME_RENJU ) {
+        j->mismatches++;
+        report( j, "%lu,,unreadable (error %d),%d,%d,,", number, INPUT_ERR, state, winner );
+        return;
+    }
+    game* g = game_create( size, type );
+    for ( size_t i = 0; i < num_moves; i++ ) {
+        if ( g->state != GAME_STATE_PLAYING ) {
+            j->mismatches++;
+            report( j, "%lu,%zu,move after the end,%d,%d,%d,%d", number, i + 1, state, winner, g->state, g->winner );
+            game_delete( g );
+            return;
+        }
+        if ( !game_make_move( g, moves[i].x, moves[i].y ) ) {
+            j->mismatches++;
+            report( j, "%lu,%zu,illegal move,%d,%d,%d,%d", number, i + 1, state, winner, g->state, g->winner );
+            game_delete( g );
+            return;
+        }
+    }
+
+    //An unfinished game is saved as stopped and replays as still playing
+    unsigned char expected = state == GAME_STATE_STOPPED ? GAME_STATE_PLAYING : state;
+    if ( g->state != expected ) {
+        j->mismatches++;
+        report( j, "%lu,,state,%d,%d,%d,%d", number, state, winner, g->state, g->winner );
+    } else if ( g->winner != winner ) {
+        j->mismatches++;
+        report( j, "%lu,,winner,%d,%d,%d,%d", number, state, winner, g->state, g->winner );
+    }
+    game_delete( g );
+}
+
+static void report( job* j, const char* format, ... )
+{
+    char line[256];
+    va_list args;
+    va_start( args, format );
+    int length = vsnprintf( line, sizeof( line ), format, args );
+    va_end( args );
+    if ( length < 0 ) {
+        return;
+    }
+    if ( ( size_t )length >= sizeof( line ) ) {
+        length = sizeof( line ) - 1;
+    }
+
+    //The path is quoted, doubling any quote in it
+    size_t needed = 2 * strlen( j->path ) + length + 4;
+    if ( j->report_length + needed > j->report_capacity ) {
+        j->report_capacity = ( j->report_length + needed ) * 2 + INITIAL_REPORT;
+        j->report = ( char * )realloc( j->report, j->report_capacity );
+        if (j->report == NULL) {
+            fprintf(stderr, "ERROR: Failed to allocate memory\n");
+            exit(1);
+        }
+    }
+    char* p = j->report + j->report_length;
+    *p++ = '"';
+    for ( const char* c = j->path; *c; c++ ) {
+        if ( *c == '"' ) {
+            *p++ = '"';
+        }
+        *p++ = *c;
+    }
+    *p++ = '"';
+    *p++ = ',';
+    memcpy( p, line, length );
+    p += length;
+    *p++ = '\n';
+    j->report_length = p - j->report;
+}
@@ -0,0 +1,288 @@
+#define _POSIX_C_SOURCE 200809L
+#include "archive.h"
+#include "error-codes.h"
+#include "board.h"
+#include "game.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define INITIAL_GAMES 1024
+
+/**
+ * Reads a little-endian number of the given width.
+ * @param p The first byte of the number.
+ * @param bytes The width of the number in bytes.
+ * @return The number.
+ */
+static uint64_t get_le( const unsigned char* p, int bytes );
+
+/**
+ * Stores a number in little-endian order.
+ * @param p The first byte to write.
+ * @param value The number.
+ * @param bytes The width of the number in bytes.
+ */
+static void put_le( unsigned char* p, uint64_t value, int bytes );
+
+/**
+ * Writes bytes to the archive, exiting with FILE_OUTPUT_ERR if they cannot be written.
+ * @param w The writer.
+ * @param bytes The bytes to write.
+ * @param length The number of bytes.
+ */
+static void write_bytes( archive_writer* w, const unsigned char* bytes, size_t length );
+
+archive* archive_open( const char* path )
+{
+    unsigned char status;
+    archive* a = archive_read( path, &status );
+    if ( a == NULL && status == MEMORY_ERR ) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    } else if ( a == NULL ) {
+        exit( status );
+    }
+    return a;
+}
+
+archive* archive_read( const char* path, unsigned char* status )
+{
+    *status = FILE_INPUT_ERR;
+    int fd = open( path, O_RDONLY );
+    if ( fd < 0 ) {
+        return NULL;
+    }
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || info.st_size < ARCHIVE_HEADER_SIZE ) {
+        close( fd );
+        return NULL;
+    }
+    void* data = mmap( NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    //The mapping stays valid after the file is closed
+    close( fd );
+    if ( data == MAP_FAILED ) {
+        return NULL;
+    }
+
+    //Header: magic, version, game count and the index at the end
+    const unsigned char* header = data;
+    uint32_t count = get_le( header + 8, 4 );
+    uint64_t index = get_le( header + 12, 8 );
+    if ( memcmp( header, ARCHIVE_MAGIC, 4 ) != 0 || get_le( header + 4, 2 ) != ARCHIVE_VERSION ||
+         index < ARCHIVE_HEADER_SIZE || index > ( uint64_t )info.st_size || ( info.st_size - index ) / 8 < count ) {
+        munmap( data, info.st_size );
+        return NULL;
+    }
+
+    archive* a = ( archive * )malloc( sizeof( archive ) );
+    if (a == NULL) {
+        munmap( data, info.st_size );
+        *status = MEMORY_ERR;
+        return NULL;
+    }
+    a->data = data;
+    a->length = info.st_size;
+    a->count = count;
+    a->index = a->data + index;
+    //Games are read in order, so let the kernel read ahead
+    posix_madvise( data, a->length, POSIX_MADV_SEQUENTIAL );
+    *status = SUCCESS;
+    return a;
+}
+
+void archive_close( archive* a )
+{
+    if ( a == NULL ) {
+        exit( NULL_POINTER_ERR );
+    }
+    munmap( ( void * )a->data, a->length );
+    free( a );
+}
+
+unsigned char archive_game_at( const archive* a, uint32_t i, archive_game* ag )
+{
+    if ( i >= a->count ) {
+        return FILE_INPUT_ERR;
+    }
+    uint64_t offset = get_le( a->index + 8 * ( size_t )i, 8 );
+    if ( offset < ARCHIVE_HEADER_SIZE || offset > a->length - ARCHIVE_RECORD_SIZE ) {
+        return FILE_INPUT_ERR;
+    }
+    const unsigned char* record = a->data + offset;
+    ag->size = record[0];
+    ag->type = record[1];
+    ag->state = record[2];
+    ag->winner = record[3];
+    ag->moves_count = get_le( record + 4, 2 );
+    ag->moves = record + ARCHIVE_RECORD_SIZE;
+    if ( ( a->length - offset - ARCHIVE_RECORD_SIZE ) / ARCHIVE_MOVE_SIZE < ag->moves_count ) {
+        return FILE_INPUT_ERR;
+    }
+    return SUCCESS;
+}
+
+unsigned char archive_move( const archive_game* ag, unsigned short i, unsigned char* x, unsigned char* y )
+{
+    unsigned int cell = get_le( ag->moves + ARCHIVE_MOVE_SIZE * i, ARCHIVE_MOVE_SIZE );
+    if ( ag->size == 0 || cell >= ( unsigned int )ag->size * ag->size ) {
+        return FILE_INPUT_ERR;
+    }
+    *x = cell % ag->size;
+    *y = cell / ag->size;
+    return SUCCESS;
+}
+
+game* archive_load( const archive_game* ag, unsigned char* status )
+{
+    //Bounds check state and winner before creating the game
+    if ( ag->state < GAME_STATE_FORBIDDEN || ag->state > GAME_STATE_FINISHED ) {
+        *status = FILE_INPUT_ERR;
+        return NULL;
+    }
+    if ( ag->winner < EMPTY_INTERSECTION || ag->winner > WHITE_STONE ) {
+        *status = FILE_INPUT_ERR;
+        return NULL;
+    }
+    game* g = game_new( ag->size, ag->type, status );
+    if ( g == NULL ) {
+        return NULL;
+    }
+    g->state = ag->state;
+    g->winner = ag->winner;
+
+    unsigned char x;
+    unsigned char y;
+    for ( unsigned short i = 0; i < ag->moves_count; i++ ) {
+        *status = archive_move( ag, i, &x, &y );
+        if ( *status != SUCCESS ) {
+            game_delete( g );
+            return NULL;
+        }
+        board_set( g->board, x, y, g->stone );
+        if ( !save_move( g, x, y ) ) {
+            //More moves than intersections
+            game_delete( g );
+            *status = FILE_INPUT_ERR;
+            return NULL;
+        }
+
+        //Switch players
+        if ( g->stone == BLACK_STONE ) {
+            g->stone = WHITE_STONE;
+        } else {
+            g->stone = BLACK_STONE;
+        }
+    }
+    return g;
+}
+
+archive_writer* archive_writer_create( const char* path )
+{
+    archive_writer* w = ( archive_writer * )malloc( sizeof( archive_writer ) );
+    if (w == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    w->file = fopen( path, "wb" );
+    if ( w->file == NULL ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    w->position = 0;
+    w->count = 0;
+    w->capacity = INITIAL_GAMES;
+    w->offsets = ( uint64_t * )malloc( w->capacity * sizeof( uint64_t ) );
+    if (w->offsets == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+
+    //Leave room for the header, written on close once the index is known
+    unsigned char header[ARCHIVE_HEADER_SIZE] = { 0 };
+    write_bytes( w, header, ARCHIVE_HEADER_SIZE );
+    return w;
+}
+
+void archive_write( archive_writer* w, const game* g )
+{
+    if ( w->count == w->capacity ) {
+        w->capacity = w->capacity * 2;
+        w->offsets = ( uint64_t * )realloc( w->offsets, w->capacity * sizeof( uint64_t ) );
+        if (w->offsets == NULL) {
+            fprintf(stderr, "ERROR: Failed to allocate memory\n");
+            exit(1);
+        }
+    }
+    w->offsets[w->count++] = w->position;
+
+    size_t num_moves = g->moves_count;
+    if ( num_moves > UINT16_MAX ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    //An unfinished game is stored as stopped, like game_save does, since archive_load only takes ended games
+    unsigned char state = g->state == GAME_STATE_PLAYING ? GAME_STATE_STOPPED : g->state;
+    unsigned char record[ARCHIVE_RECORD_SIZE] = { g->board->size, g->type, state, g->winner };
+    put_le( record + 4, num_moves, 2 );
+    write_bytes( w, record, ARCHIVE_RECORD_SIZE );
+
+    unsigned char cell[ARCHIVE_MOVE_SIZE];
+    for ( size_t i = 0; i < num_moves; i++ ) {
+        put_le( cell, g->moves[i].y * g->board->size + g->moves[i].x, ARCHIVE_MOVE_SIZE );
+        write_bytes( w, cell, ARCHIVE_MOVE_SIZE );
+    }
+}
+
+void archive_writer_close( archive_writer* w )
+{
+    if ( w == NULL ) {
+        exit( NULL_POINTER_ERR );
+    }
+    //Index after the last game
+    uint64_t index = w->position;
+    unsigned char offset[8];
+    for ( uint32_t i = 0; i < w->count; i++ ) {
+        put_le( offset, w->offsets[i], 8 );
+        write_bytes( w, offset, 8 );
+    }
+
+    //Header at the start
+    unsigned char header[ARCHIVE_HEADER_SIZE] = { 0 };
+    memcpy( header, ARCHIVE_MAGIC, 4 );
+    put_le( header + 4, ARCHIVE_VERSION, 2 );
+    put_le( header + 8, w->count, 4 );
+    put_le( header + 12, index, 8 );
+    if ( fseek( w->file, 0, SEEK_SET ) != 0 || fwrite( header, 1, ARCHIVE_HEADER_SIZE, w->file ) != ARCHIVE_HEADER_SIZE ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    if ( fclose( w->file ) != 0 ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    free( w->offsets );
+    free( w );
+}
+
+static uint64_t get_le( const unsigned char* p, int bytes )
+{
+    uint64_t value = 0;
+    for ( int i = bytes - 1; i >= 0; i-- ) {
+        value = value << 8 | p[i];
+    }
+    return value;
+}
+
+static void put_le( unsigned char* p, uint64_t value, int bytes )
+{
+    for ( int i = 0; i < bytes; i++ ) {
+        p[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static void write_bytes( archive_writer* w, const unsigned char* bytes, size_t length )
+{
+    if ( fwrite( bytes, 1, length, w->file ) != length ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    w->position += length;
+}
@@ -0,0 +1,128 @@
+#ifndef _ARCHIVE_H_
+#define _ARCHIVE_H_
+#include "game.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#define ARCHIVE_MAGIC "GMKB"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_HEADER_SIZE 20
+#define ARCHIVE_RECORD_SIZE 6
+#define ARCHIVE_MOVE_SIZE 2
+
+/*
+ * An archive holds many games in one binary file. All numbers are little-endian.
+ *
+ * File header (ARCHIVE_HEADER_SIZE bytes):
+ *   magic "GMKB", version (2 bytes), reserved (2 bytes), number of games (4 bytes), offset of the index (8 bytes)
+ * Game records, one after another, each ARCHIVE_RECORD_SIZE bytes followed by its moves:
+ *   board size, game type, game state, winner (1 byte each), number of moves (2 bytes)
+ *   every move as its intersection index y * size + x (ARCHIVE_MOVE_SIZE bytes)
+ * Index at the end of the file:
+ *   the offset of every game record (8 bytes each)
+ */
+
+/**
+ * A read-only archive mapped into memory.
+ */
+typedef struct {
+    const unsigned char* data;
+    size_t length;
+    uint32_t count;
+    const unsigned char* index;
+} archive;
+
+/**
+ * One game of a mapped archive. moves points into the mapping and stays valid until the archive is closed.
+ */
+typedef struct {
+    unsigned char size;
+    unsigned char type;
+    unsigned char state;
+    unsigned char winner;
+    unsigned short moves_count;
+    const unsigned char* moves;
+} archive_game;
+
+/**
+ * An archive being written. Games are appended as they come and the index is written on close.
+ */
+typedef struct {
+    FILE* file;
+    uint64_t position;
+    uint64_t* offsets;
+    uint32_t count;
+    uint32_t capacity;
+} archive_writer;
+
+/**
+ * Maps an archive into memory and checks its header and index. Exits with FILE_INPUT_ERR if
+ * the file cannot be read or is not a valid archive.
+ * @param path Path to the archive.
+ * @return The newly opened archive.
+ */
+archive* archive_open(const char* path);
+
+/**
+ * Opens an archive like archive_open, but reports errors instead of exiting.
+ * @param path Path to the archive.
+ * @param status Reference to the location where SUCCESS, FILE_INPUT_ERR or MEMORY_ERR is stored.
+ * @return The newly opened archive, or NULL if it could not be opened.
+ */
+archive* archive_read(const char* path, unsigned char* status);
+
+/**
+ * Unmaps an archive and frees its memory.
+ * @param a The archive to close.
+ */
+void archive_close(archive* a);
+
+/**
+ * Reads the record of one game without copying its moves.
+ * @param a The archive.
+ * @param i The number of the game, below a->count.
+ * @param ag Reference to the location where the record is stored.
+ * @return SUCCESS, or FILE_INPUT_ERR if the record lies outside the file.
+ */
+unsigned char archive_game_at(const archive* a, uint32_t i, archive_game* ag);
+
+/**
+ * Decodes one move of a game record.
+ * @param ag The game record.
+ * @param i The number of the move, below ag->moves_count.
+ * @param x Reference to the location where the horizontal coordinate is stored.
+ * @param y Reference to the location where the vertical coordinate is stored.
+ * @return SUCCESS, or FILE_INPUT_ERR if the move is off the board.
+ */
+unsigned char archive_move(const archive_game* ag, unsigned short i, unsigned char* x, unsigned char* y);
+
+/**
+ * Creates a game from a record, placing its stones the way game_load does, and reports errors instead of exiting.
+ * @param ag The game record.
+ * @param status Reference to the location where SUCCESS or the error code is stored. A record with a bad
+ *        state, winner or move, or with more moves than intersections, gives FILE_INPUT_ERR.
+ * @return The newly created game, or NULL if the record is not a valid game.
+ */
+game* archive_load(const archive_game* ag, unsigned char* status);
+
+/**
+ * Creates an archive at the given path, replacing any existing file. Exits with FILE_OUTPUT_ERR
+ * if the file cannot be written.
+ * @param path Path to the archive.
+ * @return The newly created writer.
+ */
+archive_writer* archive_writer_create(const char* path);
+
+/**
+ * Appends a game to an archive. A game still being played is stored as stopped.
+ * @param w The writer.
+ * @param g The game to append.
+ */
+void archive_write(archive_writer* w, const game* g);
+
+/**
+ * Writes the index and header, closes the file and frees the writer.
+ * @param w The writer.
+ */
+void archive_writer_close(archive_writer* w);
+#endif
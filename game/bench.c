@@ -0,0 +1,423 @@
+#define _POSIX_C_SOURCE 200809L
+#include "game.h"
+#include "board.h"
+#include "io.h"
+#include "threat.h"
+#include "error-codes.h"
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#define MAX_PATH 4096
+#define MAX_CELLS ( BOARD_MAX_SIZE * BOARD_MAX_SIZE )
+#define DEFAULT_SEED 1
+#define DEFAULT_GAMES 200
+#define DEFAULT_DEPTH 2
+#define PERFT_OPENING 6
+#define FULL_CHECKS 10000000
+#define THREAT_SCANS 20
+
+/**
+ * The settings shared by every benchmark.
+ */
+typedef struct {
+    uint64_t seed;
+    int games;
+    int depth;
+    const char* directory;
+} bench_options;
+
+/**
+ * Prints out the error message to the console if command line args are not correct.
+ */
+static void arg_error();
+
+/**
+ * Returns the next number of a splitmix64 sequence.
+ * @param state The state of the sequence, advanced by one step.
+ * @return A pseudo-random 64-bit number.
+ */
+static uint64_t next_random( uint64_t* state );
+
+/**
+ * Returns the number of seconds since an arbitrary fixed point.
+ * @return The time in seconds.
+ */
+static double now();
+
+/**
+ * Prints one result line.
+ * @param name The name of the benchmark.
+ * @param size The board size.
+ * @param type The game type.
+ * @param ops The number of operations measured.
+ * @param seconds The time they took.
+ */
+static void report( const char* name, unsigned char size, unsigned char type, unsigned long ops, double seconds );
+
+/**
+ * Plays random moves until the game ends or the given number of moves is reached, without printing.
+ * @param g The game.
+ * @param rng The random number state.
+ * @param limit The largest number of moves to play.
+ */
+static void play_random( game* g, uint64_t* rng, int limit );
+
+/**
+ * Measures game_place_stone by playing random games to the end. The board printed at the end of
+ * each game is sent to /dev/null.
+ * @param size The board size.
+ * @param type The game type.
+ * @param options The benchmark settings.
+ */
+static void bench_place_stone( unsigned char size, unsigned char type, const bench_options* options );
+
+/**
+ * Measures find_max_line on every empty intersection of random positions.
+ * @param size The board size.
+ * @param type The game type.
+ * @param options The benchmark settings.
+ */
+static void bench_find_max_line( unsigned char size, unsigned char type, const bench_options* options );
+
+/**
+ * Measures board_is_full on a half filled board.
+ * @param size The board size.
+ * @param type The game type.
+ * @param options The benchmark settings.
+ */
+static void bench_board_is_full( unsigned char size, unsigned char type, const bench_options* options );
+
+/**
+ * Measures game_export and then game_import on random games saved in the scratch directory.
+ * @param size The board size.
+ * @param type The game type.
+ * @param options The benchmark settings.
+ */
+static void bench_import_export( unsigned char size, unsigned char type, const bench_options* options );
+
+/**
+ * Measures threat_scan with every kernel the processor supports on random positions, and checks that
+ * the vector kernels build the same maps as the scalar one.
+ * @param size The board size.
+ * @param type The game type.
+ * @param options The benchmark settings.
+ */
+static void bench_threat_scan( unsigned char size, unsigned char type, const bench_options* options );
+
+/**
+ * Counts the positions reached by every sequence of legal moves from a fixed random opening, then does
+ * it again while keeping the line cache of the game up to date.
+ * @param size The board size.
+ * @param type The game type.
+ * @param options The benchmark settings.
+ */
+static void bench_perft( unsigned char size, unsigned char type, const bench_options* options );
+
+/**
+ * Counts the positions reached in the given number of moves, not going past the end of the game.
+ * @param g The game, restored before returning.
+ * @param depth The number of moves.
+ * @return The number of positions depth moves deep, or at the end of a game before that.
+ */
+static unsigned long perft( game* g, int depth );
+
+/**
+ * Runs every benchmark on 15x15, 17x17 and 19x19 boards for both game types and prints the results
+ * as CSV: benchmark, size, type, operations, seconds and operations per second. Random positions come
+ * from a fixed seed, so the operation counts only change when the rules or move generation do.
+ * Use -seed followed by a number to change the random positions.
+ * Use -games followed by a number to set how many random games each benchmark uses (200 by default).
+ * Use -depth followed by a number to set the perft depth (2 by default).
+ * Use -tmp followed by a directory to hold the files of the import and export benchmark (/tmp by default).
+ * @param argc The total number of arguments.
+ * @param argv[] Array of arguments
+ * return 0 if successful.
+ */
+int main( int argc, char *argv[] ) {
+    bench_options options = { DEFAULT_SEED, DEFAULT_GAMES, DEFAULT_DEPTH, "/tmp" };
+    if ( argc % 2 == 0 ) {
+        arg_error();
+    }
+    for ( int i = 1; i < argc; i += 2 ) {
+        if ( strcmp( argv[i], "-seed" ) == 0 ) {
+            options.seed = strtoull( argv[i + 1], NULL, 10 );
+        } else if ( strcmp( argv[i], "-games" ) == 0 ) {
+            options.games = atoi( argv[i + 1] );
+        } else if ( strcmp( argv[i], "-depth" ) == 0 ) {
+            options.depth = atoi( argv[i + 1] );
+        } else if ( strcmp( argv[i], "-tmp" ) == 0 ) {
+            options.directory = argv[i + 1];
+        } else {
+            arg_error();
+        }
+    }
+    if ( options.games <= 0 || options.depth < 0 ) {
+        arg_error();
+    }
+
+    const unsigned char sizes[] = { 15, 17, 19 };
+    const unsigned char types[] = { GAME_FREESTYLE, GAME_RENJU };
+    printf( "benchmark,size,type,ops,seconds,ops_per_sec\n" );
+    for ( int s = 0; s < 3; s++ ) {
+        for ( int t = 0; t < 2; t++ ) {
+            bench_place_stone( sizes[s], types[t], &options );
+            bench_find_max_line( sizes[s], types[t], &options );
+            bench_board_is_full( sizes[s], types[t], &options );
+            bench_import_export( sizes[s], types[t], &options );
+            bench_threat_scan( sizes[s], types[t], &options );
+            bench_perft( sizes[s], types[t], &options );
+        }
+    }
+    return 0;
+}
+
+static void arg_error() {
+    printf( "usage: ./bench [-seed <number>] [-games <count>] [-depth <moves>] [-tmp <directory>]\n" );
+    exit( ARGUMENT_ERR );
+}
+
+static uint64_t next_random( uint64_t* state )
+{
+    uint64_t z = ( *state += 0x9E3779B97F4A7C15ULL );
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+}
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime( CLOCK_MONOTONIC, &t );
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void report( const char* name, unsigned char size, unsigned char type, unsigned long ops, double seconds )
+{
+    printf( "%s,%d,%s,%lu,%.6f,%.0f\n", name, size, type == GAME_RENJU ? "renju" : "freestyle", ops, seconds,
+            seconds > 0 ? ops / seconds : 0.0 );
+    fflush( stdout );
+}
+
+static void play_random( game* g, uint64_t* rng, int limit )
+{
+    for ( int i = 0; i < limit && g->state == GAME_STATE_PLAYING && !board_is_full( g->board ); i++ ) {
+        unsigned char x;
+        unsigned char y;
+        board_empty_point( g->board, next_random( rng ) % board_empty_count( g->board ), &x, &y );
+        game_make_move( g, x, y );
+    }
+}
+
+static void bench_place_stone( unsigned char size, unsigned char type, const bench_options* options )
+{
+    uint64_t rng = options->seed;
+    unsigned long ops = 0;
+    double seconds = 0;
+
+    //game_place_stone prints the board when a game ends
+    fflush( stdout );
+    int saved = dup( STDOUT_FILENO );
+    int null = open( "/dev/null", O_WRONLY );
+    dup2( null, STDOUT_FILENO );
+    for ( int i = 0; i < options->games; i++ ) {
+        game* g = game_create( size, type );
+        unsigned char xs[MAX_CELLS];
+        unsigned char ys[MAX_CELLS];
+        int count = 0;
+        for ( int y = 0; y < size; y++ ) {
+            for ( int x = 0; x < size; x++ ) {
+                xs[count] = x;
+                ys[count++] = y;
+            }
+        }
+        //Shuffle the intersections into a random game
+        for ( int j = count - 1; j > 0; j-- ) {
+            int k = next_random( &rng ) % ( j + 1 );
+            unsigned char x = xs[j];
+            unsigned char y = ys[j];
+            xs[j] = xs[k];
+            ys[j] = ys[k];
+            xs[k] = x;
+            ys[k] = y;
+        }
+        double start = now();
+        for ( int j = 0; j < count && g->state == GAME_STATE_PLAYING; j++ ) {
+            game_place_stone( g, xs[j], ys[j] );
+            g->stone = g->stone == BLACK_STONE ? WHITE_STONE : BLACK_STONE;
+            ops++;
+        }
+        seconds += now() - start;
+        game_delete( g );
+    }
+    fflush( stdout );
+    dup2( saved, STDOUT_FILENO );
+    close( saved );
+    close( null );
+    report( "place_stone", size, type, ops, seconds );
+}
+
+static void bench_find_max_line( unsigned char size, unsigned char type, const bench_options* options )
+{
+    uint64_t rng = options->seed;
+    unsigned long ops = 0;
+    unsigned long total = 0;
+    double seconds = 0;
+    for ( int i = 0; i < options->games; i++ ) {
+        game* g = game_create( size, type );
+        play_random( g, &rng, size * size / 3 );
+        double start = now();
+        for ( unsigned short j = 0; j < board_empty_count( g->board ); j++ ) {
+            unsigned char x;
+            unsigned char y;
+            unsigned char open_fours = 0;
+            board_empty_point( g->board, j, &x, &y );
+            total += find_max_line( g, x, y, &open_fours );
+            ops++;
+        }
+        seconds += now() - start;
+        game_delete( g );
+    }
+    //Keep the calls from being optimized away
+    if ( total == 0 ) {
+        fprintf( stderr, "find_max_line found nothing\n" );
+    }
+    report( "find_max_line", size, type, ops, seconds );
+}
+
+static void bench_board_is_full( unsigned char size, unsigned char type, const bench_options* options )
+{
+    uint64_t rng = options->seed;
+    game* g = game_create( size, type );
+    play_random( g, &rng, size * size / 2 );
+    //Reached through a volatile pointer so every call is made
+    board* volatile b = g->board;
+    unsigned long full = 0;
+    double start = now();
+    for ( unsigned long i = 0; i < FULL_CHECKS; i++ ) {
+        full += board_is_full( b );
+    }
+    double seconds = now() - start;
+    if ( full != 0 ) {
+        fprintf( stderr, "board_is_full found a full board\n" );
+    }
+    game_delete( g );
+    report( "board_is_full", size, type, FULL_CHECKS, seconds );
+}
+
+static void bench_import_export( unsigned char size, unsigned char type, const bench_options* options )
+{
+    uint64_t rng = options->seed;
+    char path[MAX_PATH];
+    double seconds = 0;
+    for ( int i = 0; i < options->games; i++ ) {
+        game* g = game_create( size, type );
+        play_random( g, &rng, size * size );
+        if ( snprintf( path, MAX_PATH, "%s/bench-%d-%d.gmk", options->directory, ( int )getpid(), i ) >= MAX_PATH ) {
+            exit( FILE_OUTPUT_ERR );
+        }
+        double start = now();
+        game_export( g, path );
+        seconds += now() - start;
+        game_delete( g );
+    }
+    report( "game_export", size, type, options->games, seconds );
+
+    seconds = 0;
+    for ( int i = 0; i < options->games; i++ ) {
+        snprintf( path, MAX_PATH, "%s/bench-%d-%d.gmk", options->directory, ( int )getpid(), i );
+        double start = now();
+        game* g = game_import( path );
+        seconds += now() - start;
+        game_delete( g );
+        remove( path );
+    }
+    report( "game_import", size, type, options->games, seconds );
+}
+
+static void bench_threat_scan( unsigned char size, unsigned char type, const bench_options* options )
+{
+    uint64_t rng = options->seed;
+    double seconds[NUM_THREAT_KERNELS] = { 0 };
+    //Too large for the stack
+    threat_map* expected = ( threat_map * )malloc( 2 * sizeof( threat_map ) );
+    if (expected == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    threat_map* map = expected + 1;
+    for ( int i = 0; i < options->games; i++ ) {
+        game* g = game_create( size, type );
+        play_random( g, &rng, size * size / 3 );
+        threat_use_kernel( THREAT_KERNEL_SCALAR );
+        threat_scan( g, expected );
+        for ( unsigned char kernel = 0; kernel < NUM_THREAT_KERNELS; kernel++ ) {
+            if ( !threat_use_kernel( kernel ) ) {
+                continue;
+            }
+            double start = now();
+            for ( int j = 0; j < THREAT_SCANS; j++ ) {
+                threat_scan( g, map );
+            }
+            seconds[kernel] += now() - start;
+            if ( memcmp( map->patterns[0], expected->patterns[0], size * size ) != 0 ||
+                 memcmp( map->patterns[1], expected->patterns[1], size * size ) != 0 ) {
+                fprintf( stderr, "threat_scan with %s differs from scalar\n", threat_kernel_name( kernel ) );
+            }
+        }
+        game_delete( g );
+    }
+    free( expected );
+    for ( unsigned char kernel = 0; kernel < NUM_THREAT_KERNELS; kernel++ ) {
+        if ( threat_kernel_supported( kernel ) ) {
+            char name[32];
+            snprintf( name, sizeof( name ), "threat_scan_%s", threat_kernel_name( kernel ) );
+            report( name, size, type, ( unsigned long )options->games * THREAT_SCANS, seconds[kernel] );
+        }
+    }
+}
+
+static void bench_perft( unsigned char size, unsigned char type, const bench_options* options )
+{
+    uint64_t rng = options->seed;
+    game* g = game_create( size, type );
+    //A few random stones near the middle make the positions less symmetric than an empty board
+    for ( int i = 0; i < PERFT_OPENING; i++ ) {
+        unsigned char x = size / 2 - 2 + next_random( &rng ) % 5;
+        unsigned char y = size / 2 - 2 + next_random( &rng ) % 5;
+        if ( !game_make_move( g, x, y ) ) {
+            i--;
+        }
+    }
+    double start = now();
+    unsigned long nodes = perft( g, options->depth );
+    double seconds = now() - start;
+    char name[32];
+    snprintf( name, sizeof( name ), "perft_%d", options->depth );
+    report( name, size, type, nodes, seconds );
+
+    //Again with the line cache kept up to date on every move
+    game_track_lines( g, true );
+    start = now();
+    nodes = perft( g, options->depth );
+    seconds = now() - start;
+    game_delete( g );
+    snprintf( name, sizeof( name ), "perft_%d_lines", options->depth );
+    report( name, size, type, nodes, seconds );
+}
+
+static unsigned long perft( game* g, int depth )
+{
+    if ( depth == 0 || g->state != GAME_STATE_PLAYING ) {
+        return 1;
+    }
+    unsigned long nodes = 0;
+    for ( unsigned char y = 0; y < g->board->size; y++ ) {
+        for ( unsigned char x = 0; x < g->board->size; x++ ) {
+            if ( game_make_move( g, x, y ) ) {
+                nodes += perft( g, depth - 1 );
+                game_unmake_move( g );
+            }
+        }
+    }
+    return nodes;
+}
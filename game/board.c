@@ -1,30 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
 #include "board.h"
 #include "error-codes.h"
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/**
+ * Number of lines kept per color and axis, enough for the 2 * size - 1 diagonals.
+ */
+#define LINES_PER_AXIS( size ) ( 2 * ( size ) - 1 )
+
+/**
+ * Room for one frame: a cursor move and a 3 byte glyph per intersection is more than a full redraw needs.
+ */
+#define FRAME_BYTES( size ) ( 16 * ( size ) * ( size ) + 64 )
+
+/**
+ * Escape sequences to clear the screen from the top and from the cursor down.
+ */
+#define CLEAR_SCREEN "\033[H\033[J"
+#define CLEAR_BELOW "\033[J"
+
+/**
+ * Random keys for every color and cell, followed by the side to move key, filled on first use.
+ */
+#define ZOBRIST_SEED 0x9E3779B97F4A7C15ULL
+static uint64_t zobrist_keys[2 * BOARD_MAX_SIZE * BOARD_MAX_SIZE + 1];
+static pthread_once_t zobrist_ready = PTHREAD_ONCE_INIT;
+
+/**
+ * Fills the Zobrist key table from a fixed seed so that hashes are reproducible across runs.
+ * Boards can be created on several threads at once, so the table is filled under pthread_once.
+ */
+static void zobrist_init();
+
+/**
+ * Computes the Zobrist keys. Run once by zobrist_init.
+ */
+static void zobrist_fill();
+
+/**
+ * Appends the glyph of an intersection to a frame.
+ * @param frame The position in the frame to write to.
+ * @param stone The content of the intersection.
+ * @return The position after the glyph.
+ */
+static char* put_glyph( char* frame, unsigned char stone );
+
+/**
+ * Writes a whole frame to the standard output, after anything still buffered by stdio.
+ * @param frame The frame.
+ * @param length The number of bytes in the frame.
+ */
+static void write_frame( const char* frame, size_t length );
+
+/**
+ * Finds the line through the given intersection in the bitboard array of the given color and axis.
+ * @param b Reference to the current board.
+ * @param stone The color of the bitboard (BLACK_STONE or WHITE_STONE).
+ * @param axis The axis of the line.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param pos Reference to the location where the bit index of (x, y) is stored.
+ * @return The index of the line in b->lines.
+ */
+static int line_index( const board* b, unsigned char stone, unsigned char axis, unsigned char x, unsigned char y, unsigned char* pos );
+
+/**
+ * Writes the letters of a column: A to Z, then AA, AB and so on.
+ * @param x The column.
+ * @param name The location to write to, not terminated.
+ * @return The number of letters written (1 or 2).
+ */
+static int column_name( unsigned char x, char* name );
+
+/**
+ * Returns whether the last frame printed in place is still where it was drawn: the frame and the lines
+ * printed under it fit on the terminal, so it has not scrolled. Output that is not a terminal never scrolls.
+ * @param b The board that was printed.
+ * @return True if the changed intersections can be repainted at the rows they were drawn on.
+ */
+static bool frame_on_screen( const board* b );
+
+bool board_size_valid( unsigned char size )
+{
+    return size >= BOARD_MIN_SIZE && size <= BOARD_MAX_SIZE;
+}
 
 board* board_create( unsigned char size )
 {
-    if ( size != 15 && size != 17 && size != 19 ) {
-        exit( BOARD_SIZE_ERR );
-    }
-    board *b = ( board *)malloc( sizeof( board ) );
-    b->size = size;
-    
-    //Allocate memory
-    b->grid = ( unsigned char * )malloc( size * size * sizeof( char ) );
-    if (b->grid == NULL) {
+    unsigned char status;
+    board* b = board_new( size, &status );
+    if ( b == NULL && status == MEMORY_ERR ) {
         fprintf(stderr, "ERROR: Failed to allocate memory\n");
         exit(1);
+    } else if ( b == NULL ) {
+        exit( status );
     }
-    //Populate the grid with empty intersections
-    unsigned char( *grid )[ b->size ] = ( unsigned char( * )[ b->size ] ) b->grid;
+    return b;
+}
+
+board* board_new( unsigned char size, unsigned char* status )
+{
+    if ( !board_size_valid( size ) ) {
+        *status = BOARD_SIZE_ERR;
+        return NULL;
+    }
+    void* memory = malloc( board_footprint( size ) );
+    if (memory == NULL) {
+        *status = MEMORY_ERR;
+        return NULL;
+    }
+    *status = SUCCESS;
+    return board_init( memory, size );
+}
+
+size_t board_footprint( unsigned char size )
+{
+    //The struct and its arrays, each starting on an aligned offset
+    size_t stride = size + 2 * BOARD_PADDING;
+    return BOARD_ALIGN_UP( sizeof( board ) ) +
+           BOARD_ALIGN_UP( stride * stride * sizeof( char ) ) +
+           BOARD_ALIGN_UP( 2 * NUM_AXES * LINES_PER_AXIS( size ) * sizeof( line_bits ) ) +
+           2 * BOARD_ALIGN_UP( size * size * sizeof( unsigned short ) ) +
+           BOARD_ALIGN_UP( size * size * sizeof( unsigned char ) ) +
+           BOARD_ALIGN_UP( FRAME_BYTES( size ) );
+}
+
+board* board_init( void* memory, unsigned char size )
+{
+    board* b = ( board * )memory;
+    b->size = size;
+    
+    b->stride = size + 2 * BOARD_PADDING;
+    b->step[AXIS_HORIZONTAL] = 1;
+    b->step[AXIS_VERTICAL] = b->stride;
+    b->step[AXIS_DIAGONAL] = b->stride + 1;
+    b->step[AXIS_ANTIDIAGONAL] = 1 - b->stride;
+    
+    //Lay the arrays out after the struct, the hot ones first and the frame, only used for printing, last
+    char* next = ( char * )memory + BOARD_ALIGN_UP( sizeof( board ) );
+    b->grid = ( unsigned char * )next;
+    next += BOARD_ALIGN_UP( b->stride * b->stride * sizeof( char ) );
+    b->lines = ( line_bits * )next;
+    next += BOARD_ALIGN_UP( 2 * NUM_AXES * LINES_PER_AXIS( size ) * sizeof( line_bits ) );
+    b->empties = ( unsigned short * )next;
+    next += BOARD_ALIGN_UP( size * size * sizeof( unsigned short ) );
+    b->empty_slot = ( unsigned short * )next;
+    next += BOARD_ALIGN_UP( size * size * sizeof( unsigned short ) );
+    b->shown = ( unsigned char * )next;
+    next += BOARD_ALIGN_UP( size * size * sizeof( unsigned char ) );
+    b->frame = next;
+    
+    b->diff = false;
+    zobrist_init();
+    board_reset( b );
+    return b;
+}
+
+void board_reset( board* b )
+{
+    //Every intersection starts out in the empty set, with all bitboards empty
+    b->stones = 0;
+    b->hash = 0;
+    b->drawn = false;
+    b->below = 0;
+    memset( b->lines, 0, 2 * NUM_AXES * LINES_PER_AXIS( b->size ) * sizeof( line_bits ) );
+    //Surround the grid with sentinels and populate the inside with empty intersections
+    memset( b->grid, BORDER_INTERSECTION, b->stride * b->stride );
     for ( int i = b->size - 1; i >= 0; i-- ) { //Iterate through rows
         for ( int j = b->size - 1; j >= 0; j-- ) { //Iterate through columns
-            grid[i][j] = EMPTY_INTERSECTION;
+            b->grid[ BOARD_INDEX( b, j, i ) ] = EMPTY_INTERSECTION;
+            b->empties[ BOARD_CELL( b, j, i ) ] = BOARD_CELL( b, j, i );
+            b->empty_slot[ BOARD_CELL( b, j, i ) ] = BOARD_CELL( b, j, i );
         }
     }
-    return b;
 }
 
 void board_delete( board* b )
@@ -32,105 +185,135 @@ void board_delete( board* b )
     if (b == NULL ) {
         exit( NULL_POINTER_ERR );
     }
-    free( b->grid );
+    //The arrays live in the same block as the struct
     free( b );
 }
 
+board* board_copy( const board* b )
+{
+    board* copy = board_create( b->size );
+    board_assign( copy, b );
+    return copy;
+}
+
+void board_assign( board* b, const board* from )
+{
+    memcpy( b->grid, from->grid, b->stride * b->stride * sizeof( char ) );
+    memcpy( b->lines, from->lines, 2 * NUM_AXES * LINES_PER_AXIS( b->size ) * sizeof( line_bits ) );
+    memcpy( b->empties, from->empties, b->size * b->size * sizeof( unsigned short ) );
+    memcpy( b->empty_slot, from->empty_slot, b->size * b->size * sizeof( unsigned short ) );
+    b->stones = from->stones;
+    b->hash = from->hash;
+}
+
 void board_print( board* b, bool in_place )
 {
-    //Cast grid
-    unsigned char( *grid )[ b->size ] = ( unsigned char( * )[ b->size ] ) b->grid;
+    char* p = b->frame;
+    
+    //Repaint only the changed intersections if the last frame is still on screen
+    b->drawn = b->drawn && frame_on_screen( b );
+    b->below = 0;
+    if ( in_place && b->diff && b->drawn ) {
+        for ( int i = b->size - 1; i >= 0; i-- ) {
+            for ( int j = 0; j < b->size; j++ ) {
+                unsigned char stone = b->grid[ BOARD_INDEX( b, j, i ) ];
+                if ( stone != b->shown[ BOARD_CELL( b, j, i ) ] ) {
+                    //Row 1 of the screen holds the top row, and intersections start after the row number
+                    p += sprintf( p, "\033[%d;%dH", b->size - i, 4 + 2 * j );
+                    p = put_glyph( p, stone );
+                    b->shown[ BOARD_CELL( b, j, i ) ] = stone;
+                }
+            }
+        }
+        //Continue below the column letters
+        p += sprintf( p, "\033[%d;1H" CLEAR_BELOW, b->size + ( b->size > 26 ? 3 : 2 ) );
+        write_frame( b->frame, p - b->frame );
+        return;
+    }
+    
     //Clear the terminal if requested
     if ( in_place ) {
-        clear();
+        memcpy( p, CLEAR_SCREEN, strlen( CLEAR_SCREEN ) );
+        p += strlen( CLEAR_SCREEN );
     }
     //Assume the grid is populated correctly (i.e. saved game loads board, new game empty board, etc.)
     //Print the row # descending by size followed by the grid with intersections and dashes
     for ( int i = b->size - 1; i >= 0; i-- ) {
-        printf( "%2d ", (i + 1) ); //Print out row number
+        p += sprintf( p, "%2d ", (i + 1) ); //Print out row number
         //Print out the intersections with dashes
         for ( int j = 0; j < b->size; j++ ) {
             //Intersection print
-            unsigned char stone = grid[i][j];
-            if ( stone == EMPTY_INTERSECTION ) {
-                printf( "+" );
-            } else if ( stone == BLACK_STONE ) {
-                printf( "\u25CF" );
-            } else if ( stone == WHITE_STONE ) {
-                printf( "\u25CB" );
-            } else {
-                exit( STONE_TYPE_ERR );
-            }
+            unsigned char stone = b->grid[ BOARD_INDEX( b, j, i ) ];
+            p = put_glyph( p, stone );
+            b->shown[ BOARD_CELL( b, j, i ) ] = stone;
             //Dashes print
             if ( j != b->size - 1 ) {
-                printf( "-" );
+                *p++ = '-';
             }
         }
-        printf( "\n" );
-    }
-    //Print characters at bottom
-    printf("   ");
-    char letter = 'A';
-    for ( int i = 0; i < b->size; i++ ) {
-        printf( "%c", letter );
-        
-        //Space for all but the last character
-        if ( i != b->size - 1 ) {
-            printf( " " );
+        *p++ = '\n';
+    }
+    //Print characters at bottom, on two lines past column Z: the first letters above the last ones
+    for ( int line = b->size > 26 ? 0 : 1; line < 2; line++ ) {
+        memcpy( p, "   ", 3 );
+        p += 3;
+        for ( int i = 0; i < b->size; i++ ) {
+            char name[2];
+            int length = column_name( i, name );
+            if ( line == 1 ) {
+                *p++ = name[ length - 1 ];
+            } else {
+                *p++ = length == 2 ? name[0] : ' ';
+            }
+            
+            //Space for all but the last character
+            if ( i != b->size - 1 ) {
+                *p++ = ' ';
+            }
         }
-        
-        letter++;
+        *p++ = '\n';
     }
-    printf( "\n" );
+    b->drawn = in_place;
+    write_frame( b->frame, p - b->frame );
+}
+
+void board_printed_below( board* b, unsigned int lines )
+{
+    b->below += lines;
 }
 
 unsigned char board_formal_coord( board* b, unsigned char x, unsigned char y, char* formal_coord ) 
 {
-    //Assume x and y are passed in as integers from 0 to size, check that bounds are correct
-    if ( x < 0 || x > b->size || y < 0 || y > b->size ) {
+    //Assume x and y are passed in as integers from 0 to size - 1, check that bounds are correct
+    if ( x >= b->size || y >= b->size ) {
         return COORDINATE_ERR;
     }
-    //Convert to row/column coordinates, incrementing to account for 0 based index
-    char row = x + 'A';
-    y++; //Offset for zero indexing
-    char coord[4];
-    if ( y > 9 ) { //double digit number
-        char yFirstDigit = y / 10 + '0';
-        char ySecondDigit = y % 10 + '0';
-        coord[0] = row;
-        coord[1] = yFirstDigit;
-        coord[2] = ySecondDigit;
-        coord[3] = '\0';
-    } else {
-        
-        char column = y + '0';
-        coord[0] = row;
-        coord[1] = column;
-        coord[2] = '\0';
-    }
-    
-    strcpy( formal_coord, coord);
-    
+    //Column letters followed by the row number, incremented to account for 0 based index
+    int length = column_name( x, formal_coord );
+    sprintf( formal_coord + length, "%d", y + 1 );
     return SUCCESS;
 }
 
 unsigned char board_coord( board* b, const char* formal_coord, unsigned char* x, unsigned char* y )
 {
-    //Extract x and convert, easy since it is always and only the first character
-    unsigned char xTemp = formal_coord[0];
-    xTemp = xTemp - 'A';
-    //Y is harder to extract as it can have two digits. Use null terminator to determine when the string ends
-    unsigned char yTemp;
-    if ( formal_coord[2] < '0' || formal_coord[2] > '9' ) { //Single digit
-        yTemp = formal_coord[1];
-        yTemp = yTemp - '1';
-    } else { //Double digit
-        unsigned char yTempFirstDigit = formal_coord[1] - '0';
-        unsigned char yTempSecondDigit = formal_coord[2] - '0';
-        yTemp = yTempFirstDigit * 10 + yTempSecondDigit - 1;
+    //Extract x from the one or two leading letters
+    int i = 0;
+    int xTemp = -1;
+    while ( i < 2 && formal_coord[i] >= 'A' && formal_coord[i] <= 'Z' ) {
+        xTemp = ( xTemp + 1 ) * 26 + formal_coord[i] - 'A';
+        i++;
+    }
+    //Y follows with one or two digits
+    int yTemp = -1;
+    if ( formal_coord[i] >= '0' && formal_coord[i] <= '9' ) {
+        yTemp = formal_coord[i] - '0';
+        if ( formal_coord[i + 1] >= '0' && formal_coord[i + 1] <= '9' ) {
+            yTemp = yTemp * 10 + formal_coord[i + 1] - '0';
+        }
+        yTemp--; //Offset for zero indexing
     }
     //Check bounds
-    if ( xTemp < 0 || xTemp > b->size || yTemp < 0 || yTemp > b->size ) {
+    if ( xTemp < 0 || xTemp >= b->size || yTemp < 0 || yTemp >= b->size ) {
         return COORDINATE_ERR;
     }
     
@@ -141,38 +324,249 @@ unsigned char board_coord( board* b, const char* formal_coord, unsigned char* x,
 }
 
 unsigned char board_get( board* b, unsigned char x, unsigned char y ) {
-    //Cast grid
-    unsigned char( *grid )[ b->size ] = ( unsigned char( * )[ b->size ] ) b->grid;
-    //Check bounds
-    if ( x < 0 || x >= b->size || y < 0 || y >= b->size ) {
-        exit( COORDINATE_ERR );
+    //Check bounds unless built with BOARD_UNCHECKED, everything off the board is border
+    #ifndef BOARD_UNCHECKED
+    if ( x >= b->size || y >= b->size ) {
+        return BORDER_INTERSECTION;
     }
-    return grid[y][x];
+    #endif
+    return b->grid[ BOARD_INDEX( b, x, y ) ];
 }
 
-void board_set( board* b, unsigned char x, unsigned char y, unsigned char stone ){
-    if ( x < 0 || x >= b->size || y < 0 || y >= b->size ) {
-        exit( COORDINATE_ERR );
+unsigned char board_set( board* b, unsigned char x, unsigned char y, unsigned char stone ){
+    //Check bounds unless built with BOARD_UNCHECKED
+    #ifndef BOARD_UNCHECKED
+    if ( x >= b->size || y >= b->size ) {
+        return COORDINATE_ERR;
     } else if ( stone > 2 ) {
-        exit( STONE_TYPE_ERR );
+        return STONE_TYPE_ERR;
+    }
+    #endif
+    //Keep the stone counter and the empty set in sync when the occupancy changes
+    unsigned char previous = b->grid[ BOARD_INDEX( b, x, y ) ];
+    unsigned short cell = BOARD_CELL( b, x, y );
+    if ( previous == EMPTY_INTERSECTION && stone != EMPTY_INTERSECTION ) {
+        //Move the last empty cell into the hole left by this one
+        unsigned short last = b->empties[ b->size * b->size - b->stones - 1 ];
+        b->empties[ b->empty_slot[cell] ] = last;
+        b->empty_slot[last] = b->empty_slot[cell];
+        b->stones++;
+    } else if ( previous != EMPTY_INTERSECTION && stone == EMPTY_INTERSECTION ) {
+        b->stones--;
+        b->empty_slot[cell] = b->size * b->size - b->stones - 1;
+        b->empties[ b->empty_slot[cell] ] = cell;
+    }
+    //XOR the old stone out of the hash and the new one in
+    if ( previous != EMPTY_INTERSECTION ) {
+        b->hash ^= zobrist_keys[ ( previous - 1 ) * BOARD_MAX_SIZE * BOARD_MAX_SIZE + cell ];
+    }
+    if ( stone != EMPTY_INTERSECTION ) {
+        b->hash ^= zobrist_keys[ ( stone - 1 ) * BOARD_MAX_SIZE * BOARD_MAX_SIZE + cell ];
     }
-    //Cast grid
-    unsigned char( *grid )[ b->size ] = ( unsigned char( * )[ b->size ] ) b->grid;
     //Assign stone
-    grid[y][x] = stone;
+    b->grid[ BOARD_INDEX( b, x, y ) ] = stone;
+    
+    //Keep the bitboards of both colors in sync along all four axes
+    unsigned char pos;
+    for ( unsigned char axis = 0; axis < NUM_AXES; axis++ ) {
+        int black = line_index( b, BLACK_STONE, axis, x, y, &pos );
+        int white = line_index( b, WHITE_STONE, axis, x, y, &pos );
+        line_bits bit = ( line_bits ) 1 << pos;
+        b->lines[black] &= ~bit;
+        b->lines[white] &= ~bit;
+        if ( stone == BLACK_STONE ) {
+            b->lines[black] |= bit;
+        } else if ( stone == WHITE_STONE ) {
+            b->lines[white] |= bit;
+        }
+    }
+    return SUCCESS;
 }
 
 bool board_is_full( board* b ) {
-    //Cast grid
-    unsigned char( *grid )[ b->size ] = ( unsigned char( * )[ b->size ] ) b->grid;
-    //Check grid
-    bool full = true;
-    for ( int i = 0; i < b->size; i++ ) {
-        for ( int j = 0; j < b->size; j++ ) {
-            if ( grid[i][j] == 0 ) {
-                full = false;
-            }
+    return b->stones == b->size * b->size;
+}
+
+unsigned short board_empty_count( const board* b )
+{
+    return b->size * b->size - b->stones;
+}
+
+void board_empty_point( const board* b, unsigned short i, unsigned char* x, unsigned char* y )
+{
+    unsigned short cell = b->empties[i];
+    *x = cell % b->size;
+    *y = cell / b->size;
+}
+
+static int line_index( const board* b, unsigned char stone, unsigned char axis, unsigned char x, unsigned char y, unsigned char* pos )
+{
+    //Rows, diagonals and anti-diagonals are indexed by x along the line, columns by y
+    int line;
+    *pos = x;
+    if ( axis == AXIS_HORIZONTAL ) {
+        line = y;
+    } else if ( axis == AXIS_VERTICAL ) {
+        line = x;
+        *pos = y;
+    } else if ( axis == AXIS_DIAGONAL ) {
+        line = x - y + b->size - 1;
+    } else {
+        line = x + y;
+    }
+    return ( ( stone - 1 ) * NUM_AXES + axis ) * LINES_PER_AXIS( b->size ) + line;
+}
+
+line_bits board_line( const board* b, unsigned char stone, unsigned char axis, unsigned char x, unsigned char y, unsigned char* pos )
+{
+    unsigned char index;
+    line_bits bits = b->lines[ line_index( b, stone, axis, x, y, &index ) ];
+    if ( pos != NULL ) {
+        *pos = index;
+    }
+    return bits;
+}
+
+line_bits board_line_mask( const board* b, unsigned char axis, unsigned char x, unsigned char y )
+{
+    //Rows and columns cover the whole board, diagonals are shorter the further they are from the middle
+    int first = 0;
+    int last = b->size - 1;
+    if ( axis == AXIS_DIAGONAL ) {
+        int offset = x - y;
+        first = offset > 0 ? offset : 0;
+        last = offset > 0 ? b->size - 1 : b->size - 1 + offset;
+    } else if ( axis == AXIS_ANTIDIAGONAL ) {
+        int sum = x + y;
+        first = sum > b->size - 1 ? sum - ( b->size - 1 ) : 0;
+        last = sum > b->size - 1 ? b->size - 1 : sum;
+    }
+    line_bits upper = ( ( line_bits ) 1 << last << 1 ) - 1;
+    line_bits lower = ( ( line_bits ) 1 << first ) - 1;
+    return upper & ~lower;
+}
+
+unsigned char board_run_length( line_bits bits, unsigned char pos )
+{
+    if ( !( bits >> pos & 1 ) ) {
+        return 0;
+    }
+    //Count the ones from pos upwards, then the ones directly below pos, up to the ends of the line
+    line_bits above = ~( bits >> pos );
+    unsigned char up = above ? LINE_CTZ( above ) : sizeof( line_bits ) * 8 - pos;
+    unsigned char down = 0;
+    if ( pos > 0 ) {
+        line_bits below = ~( bits << ( sizeof( line_bits ) * 8 - pos ) );
+        down = below ? LINE_CLZ( below ) : pos;
+    }
+    return up + down;
+}
+
+bool board_bounds( const board* b, unsigned char margin, bounds* box )
+{
+    //Row y of each color is line y of its horizontal bitboards
+    line_bits columns = 0;
+    int min_y = -1;
+    int max_y = -1;
+    for ( int y = 0; y < b->size; y++ ) {
+        line_bits row = b->lines[y] | b->lines[ NUM_AXES * LINES_PER_AXIS( b->size ) + y ];
+        if ( row ) {
+            min_y = min_y < 0 ? y : min_y;
+            max_y = y;
+            columns |= row;
         }
     }
-    return full;
-}
\ No newline at end of file
+    if ( min_y < 0 ) {
+        return false;
+    }
+    int min_x = LINE_CTZ( columns );
+    int max_x = sizeof( line_bits ) * 8 - 1 - LINE_CLZ( columns );
+    box->min_x = min_x > margin ? min_x - margin : 0;
+    box->min_y = min_y > margin ? min_y - margin : 0;
+    box->max_x = max_x + margin < b->size ? max_x + margin : b->size - 1;
+    box->max_y = max_y + margin < b->size ? max_y + margin : b->size - 1;
+    return true;
+}
+
+static void zobrist_init()
+{
+    pthread_once( &zobrist_ready, zobrist_fill );
+}
+
+static void zobrist_fill()
+{
+    //splitmix64 sequence
+    uint64_t state = ZOBRIST_SEED;
+    for ( int i = 0; i < 2 * BOARD_MAX_SIZE * BOARD_MAX_SIZE + 1; i++ ) {
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = state;
+        z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+        z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+        zobrist_keys[i] = z ^ ( z >> 31 );
+    }
+}
+
+uint64_t board_zobrist( unsigned char stone, unsigned short cell )
+{
+    zobrist_init();
+    return zobrist_keys[ ( stone - 1 ) * BOARD_MAX_SIZE * BOARD_MAX_SIZE + cell ];
+}
+
+uint64_t board_zobrist_side()
+{
+    zobrist_init();
+    return zobrist_keys[ 2 * BOARD_MAX_SIZE * BOARD_MAX_SIZE ];
+}
+
+static int column_name( unsigned char x, char* name )
+{
+    if ( x < 26 ) {
+        name[0] = 'A' + x;
+        return 1;
+    }
+    name[0] = 'A' + x / 26 - 1;
+    name[1] = 'A' + x % 26;
+    return 2;
+}
+
+static bool frame_on_screen( const board* b )
+{
+    struct winsize window;
+    if ( ioctl( STDOUT_FILENO, TIOCGWINSZ, &window ) != 0 || window.ws_row == 0 ) {
+        return true;
+    }
+    //The rows of the board and the column letters, with the cursor on the line after whatever followed
+    unsigned int height = b->size + ( b->size > 26 ? 2 : 1 );
+    return height + b->below < window.ws_row;
+}
+
+static char* put_glyph( char* frame, unsigned char stone )
+{
+    if ( stone == EMPTY_INTERSECTION ) {
+        *frame++ = '+';
+    } else if ( stone == BLACK_STONE ) {
+        memcpy( frame, "\u25CF", 3 );
+        frame += 3;
+    } else if ( stone == WHITE_STONE ) {
+        memcpy( frame, "\u25CB", 3 );
+        frame += 3;
+    } else {
+        exit( STONE_TYPE_ERR );
+    }
+    return frame;
+}
+
+static void write_frame( const char* frame, size_t length )
+{
+    fflush( stdout );
+    while ( length > 0 ) {
+        ssize_t written = write( STDOUT_FILENO, frame, length );
+        if ( written < 0 && errno == EINTR ) {
+            continue;
+        } else if ( written <= 0 ) {
+            exit( FILE_OUTPUT_ERR );
+        }
+        frame += written;
+        length -= written;
+    }
+}
@@ -1,48 +1,176 @@
 #ifndef _BOARD_H_
 #define _BOARD_H_
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #define EMPTY_INTERSECTION 0
 #define BLACK_STONE 1
 #define WHITE_STONE 2
+#define BORDER_INTERSECTION 3
+#define BOARD_PADDING 5
+#define BOARD_MIN_SIZE 15
+#ifndef BOARD_MAX_SIZE
+#define BOARD_MAX_SIZE 64
+#endif
+#define BOARD_COORD_LENGTH 5 //Longest formal coordinate, such as BL64, with its terminator
+#define AXIS_HORIZONTAL 0
+#define AXIS_VERTICAL 1
+#define AXIS_DIAGONAL 2
+#define AXIS_ANTIDIAGONAL 3
+#define NUM_AXES 4
 #define clear() printf("\033[H\033[J")
+#define BOARD_INDEX( b, x, y ) ( ( ( y ) + BOARD_PADDING ) * ( b )->stride + ( x ) + BOARD_PADDING )
+#define BOARD_CELL( b, x, y ) ( ( y ) * ( b )->size + ( x ) )
+#define BOARD_ALIGN 16
+#define BOARD_ALIGN_UP( n ) ( ( ( n ) + BOARD_ALIGN - 1 ) & ~( size_t )( BOARD_ALIGN - 1 ) )
+
+/**
+ * One bit per intersection along a single row, column or diagonal of the board, with LINE_CTZ and LINE_CLZ
+ * counting its trailing and leading zeros. Builds limited to boards of 32 or less keep 32-bit lines.
+ */
+#if BOARD_MAX_SIZE > 64
+#error "BOARD_MAX_SIZE is limited to 64 by the line bitboards"
+#elif BOARD_MAX_SIZE > 32
+typedef uint64_t line_bits;
+#define LINE_CTZ( bits ) __builtin_ctzll( bits )
+#define LINE_CLZ( bits ) __builtin_clzll( bits )
+#else
+typedef uint32_t line_bits;
+#define LINE_CTZ( bits ) __builtin_ctz( bits )
+#define LINE_CLZ( bits ) __builtin_clz( bits )
+#endif
 
+/**
+ * A rectangle of intersections, corners included.
+ */
+typedef struct {
+    unsigned char min_x;
+    unsigned char min_y;
+    unsigned char max_x;
+    unsigned char max_y;
+} bounds;
+
+/**
+ * The grid is surrounded by BOARD_PADDING rings of BORDER_INTERSECTION so that walking off the edge
+ * stops on a sentinel instead of needing a bounds check. Intersection (x, y) lives at BOARD_INDEX( b, x, y )
+ * and step holds the index delta of one move along each axis.
+ * The empty intersections are kept as a set of BOARD_CELL numbers: empties[0 .. size * size - stones)
+ * lists them in no particular order and empty_slot maps a cell number back to its place in that list.
+ * hash is the Zobrist key of the stones on the board, the XOR of one random key per occupied cell and color.
+ * frame is the buffer board_print renders into. With diff set, shown holds the stones of the last frame
+ * printed in place (valid when drawn is true), so the next one only repaints what changed, and below counts
+ * the lines printed under that frame since, to tell whether the terminal scrolled it.
+ */
 typedef struct {
     unsigned char size;
+    unsigned char stride;
+    int step[NUM_AXES];
     unsigned char* grid;
+    line_bits* lines;
+    unsigned short stones;
+    unsigned short* empties;
+    unsigned short* empty_slot;
+    uint64_t hash;
+    char* frame;
+    unsigned char* shown;
+    bool drawn;
+    bool diff;
+    unsigned int below;
 } board;
 
 /**
- * Dynamically allocates memory to creat a new board struct. Initializes size if input is valid, exiting with
+ * Returns whether boards of the given size can be created.
+ * @param size The length of one side.
+ * @return True for sizes from BOARD_MIN_SIZE (15) to BOARD_MAX_SIZE (64 unless built with a smaller one).
+ */
+bool board_size_valid(unsigned char size);
+
+/**
+ * Dynamically allocates memory to creat a new board struct, with all of its arrays in the same block. Initializes size if input is valid, exiting with
  * an error if not. All intersections set to EMPTY_INTERSECTION.
  * @param size The size to make the new board (length of one side)
  * @return The newly created board struct.
  */
 board* board_create(unsigned char size);
 
+/**
+ * Creates a board like board_create, but reports errors instead of exiting.
+ * @param size The size to make the new board (length of one side)
+ * @param status Reference to the location where SUCCESS, BOARD_SIZE_ERR or MEMORY_ERR is stored.
+ * @return The newly created board struct, or NULL on error.
+ */
+board* board_new(unsigned char size, unsigned char* status);
 
 /**
- * Frees the memore of the board struct and it's grid.
+ * Returns the number of bytes a board of the given size takes, struct and arrays together.
+ * @param size The length of one side, assumed to be valid.
+ * @return The size of the memory block board_init needs, a multiple of BOARD_ALIGN.
+ */
+size_t board_footprint(unsigned char size);
+
+/**
+ * Lays out an empty board in the given memory, which the caller owns, so that it can be part of a larger block.
+ * @param memory At least board_footprint( size ) bytes, aligned like malloc memory.
+ * @param size The length of one side, assumed to be valid.
+ * @return The board, at the start of the memory.
+ */
+board* board_init(void* memory, unsigned char size);
+
+/**
+ * Takes every stone off the board without freeing anything, so that it can be reused for a new game.
+ * @param b The board to empty.
+ */
+void board_reset(board* b);
+
+/**
+ * Frees the memore of a board made by board_create or board_new, struct and arrays together.
  * If the given pointer is null, exits with NULL_POINTER_ERR.
  * @param b A pointer to the board object to free.
  */
 void board_delete(board* b);
 
 /**
- * Prints the board to the standard output.
+ * Dynamically allocates an independent copy of the given board, including its bitboards,
+ * empty set and hash.
+ * @param b The board to copy.
+ * @return The newly created board struct.
+ */
+board* board_copy(const board* b);
+
+/**
+ * Copies the stones, bitboards, empty set and hash of a board into another board of the same size.
+ * @param b The board to overwrite.
+ * @param from The board to copy.
+ */
+void board_assign(board* b, const board* from);
+
+/**
+ * Prints the board to the standard output with a single write of a frame rendered in memory.
+ * When printing in place with b->diff set and the previous frame was also printed in place, only the
+ * intersections that changed are repainted and everything printed below the board is cleared. The whole
+ * board is redrawn instead when the frame and the lines recorded with board_printed_below no longer fit
+ * on the terminal, since the terminal has then scrolled the frame away from the top of the screen.
  * @param b The board struct to print out.
  * @param in_place Clears the console before printing if true.
  */
 void board_print(board* b, bool in_place);
 
+/**
+ * Records that lines were printed under the last frame, so that board_print knows when they pushed it
+ * off the top of the terminal. Only matters when printing in place with b->diff set.
+ * @param b The board that was printed.
+ * @param lines The number of lines printed, counting a line that does not end in a newline as one.
+ */
+void board_printed_below(board* b, unsigned int lines);
+
 /**
  * Converts X and Y coordinates to a Letter-Number combination familiar to the player. 
- * Stores the results in formal_coord.
+ * Stores the results in formal_coord. Columns past Z continue with two letters: AA, AB, ...
  * @param b Reference to the current board.
  * @param x The row index of the coordinate to convert.
  * @param y The column index of the coordinate to convert.
- * @param formal_coord The reference to the location where the formal coordinates are stored.
+ * @param formal_coord The reference to the location where the formal coordinates are stored, at least BOARD_COORD_LENGTH long.
  * @return 0 If the program executes successfully.
  */
 unsigned char board_formal_coord(board* b, unsigned char x, unsigned char y, char* formal_coord);
@@ -63,7 +191,7 @@ unsigned char board_coord(board* b, const char* formal_coord, unsigned char* x,
  * @param b Reference to the current board.
  * @param x The horizontal coordinate of the desired intersection.
  * @param y The vertical coordinate of the desired intersection.
- * @return The intersection occupation state at the specified coordinates.
+ * @return The intersection occupation state at the specified coordinates, BORDER_INTERSECTION if they are off the board.
  */
 unsigned char board_get(board* b, unsigned char x, unsigned char y);
 
@@ -73,12 +201,88 @@ unsigned char board_get(board* b, unsigned char x, unsigned char y);
  * @param x The horizontal coordinate of the desired intersection.
  * @param y The vertical coordinate of the desired intersection.
  * @param stone The assignment for the given intersection.
+ * @return SUCCESS, COORDINATE_ERR if the coordinates are off the board or STONE_TYPE_ERR if the stone is not
+ *         EMPTY_INTERSECTION, BLACK_STONE or WHITE_STONE, in which case the board is left unchanged.
  */
-void board_set(board* b, unsigned char x, unsigned char y, unsigned char stone);
+unsigned char board_set(board* b, unsigned char x, unsigned char y, unsigned char stone);
 
 /**
- * Determines if all intersections on the current board are assigned.
+ * Determines if all intersections on the current board are assigned. Runs in constant time.
  * @return True if all intersections are assigned, false otherwise.
  */
 bool board_is_full(board* b);
+
+/**
+ * Returns the number of empty intersections on the board.
+ * @param b Reference to the current board.
+ * @return The number of intersections set to EMPTY_INTERSECTION.
+ */
+unsigned short board_empty_count(const board* b);
+
+/**
+ * Returns one of the empty intersections on the board. The order of the empty intersections changes
+ * whenever a stone is placed or removed.
+ * @param b Reference to the current board.
+ * @param i The index of the empty intersection, from 0 to board_empty_count() - 1.
+ * @param x Reference to the location where the horizontal coordinate is stored.
+ * @param y Reference to the location where the vertical coordinate is stored.
+ */
+void board_empty_point(const board* b, unsigned short i, unsigned char* x, unsigned char* y);
+
+/**
+ * Returns the Zobrist key of a single stone. The keys are the same for every board and every run.
+ * @param stone The color of the stone (BLACK_STONE or WHITE_STONE).
+ * @param cell The BOARD_CELL number of the intersection.
+ * @return The 64-bit key XORed into the board hash while the stone is on that cell.
+ */
+uint64_t board_zobrist(unsigned char stone, unsigned short cell);
+
+/**
+ * Returns the Zobrist key XORed into a position hash when white is to move.
+ * @return The 64-bit side to move key.
+ */
+uint64_t board_zobrist_side();
+
+/**
+ * Returns the packed bitboard of the given stone color for the line running through the given
+ * intersection along the given axis. Bits are indexed by x along every axis except AXIS_VERTICAL,
+ * which is indexed by y. The lines are kept in sync with the grid by board_set.
+ * Coordinates are not bounds checked.
+ * @param b Reference to the current board.
+ * @param stone The color of the stones to return (BLACK_STONE or WHITE_STONE).
+ * @param axis The axis of the line (AXIS_HORIZONTAL, AXIS_VERTICAL, AXIS_DIAGONAL or AXIS_ANTIDIAGONAL).
+ * @param x The horizontal coordinate of an intersection on the line.
+ * @param y The vertical coordinate of an intersection on the line.
+ * @param pos Reference to the location where the bit index of (x, y) within the line is stored. May be NULL.
+ * @return The bits of the line that hold a stone of the given color.
+ */
+line_bits board_line(const board* b, unsigned char stone, unsigned char axis, unsigned char x, unsigned char y, unsigned char* pos);
+
+/**
+ * Returns the bits of the line through the given intersection that lie on the board.
+ * @param b Reference to the current board.
+ * @param axis The axis of the line.
+ * @param x The horizontal coordinate of an intersection on the line.
+ * @param y The vertical coordinate of an intersection on the line.
+ * @return A mask with one bit set for every intersection of the line.
+ */
+line_bits board_line_mask(const board* b, unsigned char axis, unsigned char x, unsigned char y);
+
+/**
+ * Determines the length of the unbroken run of set bits that contains the given bit.
+ * @param bits The line to check.
+ * @param pos The bit index within the line.
+ * @return The number of consecutive set bits through pos, 0 if pos itself is not set.
+ */
+unsigned char board_run_length(line_bits bits, unsigned char pos);
+
+/**
+ * Finds the smallest rectangle holding every stone from the row bitboards, so that scans of large,
+ * mostly empty boards can skip the empty rows and columns.
+ * @param b Reference to the current board.
+ * @param margin Intersections to add on every side, clipped to the board.
+ * @param box Reference to the location where the rectangle is stored.
+ * @return False if the board is empty, in which case box is left unchanged.
+ */
+bool board_bounds(const board* b, unsigned char margin, bounds* box);
 #endif
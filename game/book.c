@@ -0,0 +1,424 @@
+#define _POSIX_C_SOURCE 200809L
+#include "book.h"
+#include "error-codes.h"
+#include "board.h"
+#include "game.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BOOK_KEY_SEED 0x6F70656E626F6F6BULL
+#define INITIAL_STATS 4096
+#define MIN_SLOTS 16
+#define PROBE_MOVES 256
+
+/**
+ * The symmetry that undoes each symmetry: the quarter turns undo each other, the rest undo themselves.
+ */
+static const unsigned char inverse[BOOK_SYMMETRIES] = { 0, 3, 2, 1, 4, 5, 6, 7 };
+
+/**
+ * Returns the key of a stone on an intersection. The keys only depend on the color and the intersection
+ * index, not on BOARD_MAX_SIZE like the board hash, so a book works with every build.
+ * @param stone The color of the stone.
+ * @param cell The intersection index y * size + x.
+ * @return The 64-bit key.
+ */
+static uint64_t stone_key( unsigned char stone, unsigned short cell );
+
+/**
+ * Turns an intersection by one of the symmetries of the board: the identity, the three turns by a
+ * quarter, and the reflections across the two middle lines and the two diagonals.
+ * @param size The board size.
+ * @param symmetry The symmetry, from 0 to BOOK_SYMMETRIES - 1.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @return The index y * size + x of the turned intersection.
+ */
+static unsigned short transform( unsigned char size, int symmetry, unsigned char x, unsigned char y );
+
+/**
+ * Returns the smallest of the keys of the symmetric copies of a position, which is its key in the book.
+ * @param keys The BOOK_SYMMETRIES keys.
+ * @return The smallest key.
+ */
+static uint64_t smallest( const uint64_t* keys );
+
+/**
+ * Finds the slot of a position and move in the builder, the empty slot where it goes if it is new.
+ * @param w The builder.
+ * @param key The position key.
+ * @param cell The move.
+ * @return The index of the slot.
+ */
+static size_t stat_slot( const book_builder* w, uint64_t key, unsigned short cell );
+
+/**
+ * Doubles the slots of the builder.
+ * @param w The builder.
+ */
+static void grow( book_builder* w );
+
+/**
+ * Reads a little-endian number of the given width.
+ * @param p The first byte of the number.
+ * @param bytes The width of the number in bytes.
+ * @return The number.
+ */
+static uint64_t get_le( const unsigned char* p, int bytes );
+
+/**
+ * Stores a number in little-endian order.
+ * @param p The first byte to write.
+ * @param value The number.
+ * @param bytes The width of the number in bytes.
+ */
+static void put_le( unsigned char* p, uint64_t value, int bytes );
+
+book* book_open( const char* path )
+{
+    int fd = open( path, O_RDONLY );
+    if ( fd < 0 ) {
+        fprintf( stderr, "ERROR: Failed to open opening book %s\n", path );
+        exit( FILE_INPUT_ERR );
+    }
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || info.st_size < BOOK_HEADER_SIZE ) {
+        fprintf( stderr, "ERROR: %s is not a valid opening book\n", path );
+        exit( FILE_INPUT_ERR );
+    }
+    void* data = mmap( NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    //The mapping stays valid after the file is closed
+    close( fd );
+    if ( data == MAP_FAILED ) {
+        fprintf( stderr, "ERROR: Failed to read opening book %s\n", path );
+        exit( FILE_INPUT_ERR );
+    }
+
+    book* b = ( book * )malloc( sizeof( book ) );
+    if (b == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    b->data = data;
+    b->length = info.st_size;
+
+    //Header: magic, version, what games the book is for and the size of the table
+    if ( memcmp( b->data, BOOK_MAGIC, 4 ) != 0 || get_le( b->data + 4, 2 ) != BOOK_VERSION ) {
+        fprintf( stderr, "ERROR: %s is not a valid opening book\n", path );
+        exit( FILE_INPUT_ERR );
+    }
+    b->size = b->data[6];
+    b->type = b->data[7];
+    b->moves = get_le( b->data + 8, 2 );
+    b->count = get_le( b->data + 12, 4 );
+    b->slots = get_le( b->data + 16, 4 );
+    if ( !board_size_valid( b->size ) || ( b->type != GAME_FREESTYLE && b->type != GAME_RENJU ) ) {
+        fprintf( stderr, "ERROR: %s is not a valid opening book\n", path );
+        exit( FILE_INPUT_ERR );
+    }
+    if ( b->slots == 0 || ( b->slots & ( b->slots - 1 ) ) != 0 || b->count > b->slots ||
+         b->length != BOOK_HEADER_SIZE + ( size_t )b->slots * BOOK_ENTRY_SIZE ) {
+        fprintf( stderr, "ERROR: %s is not a valid opening book, it may be truncated\n", path );
+        exit( FILE_INPUT_ERR );
+    }
+    b->entries = b->data + BOOK_HEADER_SIZE;
+    //Probes jump around the table
+    posix_madvise( data, b->length, POSIX_MADV_RANDOM );
+    return b;
+}
+
+void book_close( book* b )
+{
+    if ( b == NULL ) {
+        exit( NULL_POINTER_ERR );
+    }
+    munmap( ( void * )b->data, b->length );
+    free( b );
+}
+
+int book_probe( const book* b, const game* g, book_move* moves, int max )
+{
+    const unsigned char size = b->size;
+    if ( g->board->size != size || g->type != b->type || g->moves_count >= b->moves ) {
+        return 0;
+    }
+    uint64_t keys[BOOK_SYMMETRIES] = { 0 };
+    for ( size_t i = 0; i < g->moves_count; i++ ) {
+        const move* m = &g->moves[i];
+        for ( int s = 0; s < BOOK_SYMMETRIES; s++ ) {
+            keys[s] ^= stone_key( m->stone, transform( size, s, m->x, m->y ) );
+        }
+    }
+    uint64_t key = smallest( keys );
+    int symmetry = 0;
+    while ( keys[symmetry] != key ) {
+        symmetry++;
+    }
+
+    //The moves of a position run from its home slot to the next empty slot
+    int count = 0;
+    uint32_t slot = key & ( b->slots - 1 );
+    for ( uint32_t probes = 0; probes < b->slots && count < max; probes++ ) {
+        const unsigned char* entry = b->entries + ( size_t )slot * BOOK_ENTRY_SIZE;
+        uint32_t games = get_le( entry + 12, 4 );
+        if ( games == 0 ) {
+            break;
+        }
+        unsigned short cell = get_le( entry + 8, 2 );
+        if ( get_le( entry, 8 ) == key && cell < size * size ) {
+            //Turn the move of the stored orientation back to the one of the game
+            unsigned short turned = transform( size, inverse[symmetry], cell % size, cell / size );
+            moves[count].x = turned % size;
+            moves[count].y = turned / size;
+            moves[count].games = games;
+            moves[count].wins = get_le( entry + 16, 4 );
+            moves[count].draws = get_le( entry + 20, 4 );
+            count++;
+        }
+        slot = ( slot + 1 ) & ( b->slots - 1 );
+    }
+    return count;
+}
+
+bool book_choose( const book* b, const game* g, unsigned char* x, unsigned char* y )
+{
+    book_move moves[PROBE_MOVES];
+    int count = book_probe( b, g, moves, PROBE_MOVES );
+    const book_move* best = NULL;
+    for ( int i = 0; i < count; i++ ) {
+        const book_move* m = &moves[i];
+        if ( board_get( g->board, m->x, m->y ) != EMPTY_INTERSECTION ) {
+            continue;
+        } else if ( g->type == GAME_RENJU && g->stone == BLACK_STONE && game_check_move( g, m->x, m->y ) == GAME_STATE_FORBIDDEN ) {
+            continue;
+        }
+        //With as many games, the most wins counting a draw as half a win
+        if ( best == NULL || m->games > best->games ||
+             ( m->games == best->games && 2 * ( uint64_t )m->wins + m->draws > 2 * ( uint64_t )best->wins + best->draws ) ) {
+            best = m;
+        }
+    }
+    if ( best == NULL ) {
+        return false;
+    }
+    *x = best->x;
+    *y = best->y;
+    return true;
+}
+
+book_builder* book_builder_create( unsigned char size, unsigned char type, unsigned short moves )
+{
+    book_builder* w = ( book_builder * )malloc( sizeof( book_builder ) );
+    if (w == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    w->size = size;
+    w->type = type;
+    w->moves = moves < BOOK_MAX_MOVES ? moves : BOOK_MAX_MOVES;
+    w->count = 0;
+    w->capacity = INITIAL_STATS;
+    w->stats = ( book_stat * )calloc( w->capacity, sizeof( book_stat ) );
+    if (w->stats == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    return w;
+}
+
+bool book_add( book_builder* w, const game* g )
+{
+    const unsigned char size = w->size;
+    if ( g->board->size != size || g->type != w->type ) {
+        return false;
+    } else if ( g->state != GAME_STATE_FINISHED && g->state != GAME_STATE_FORBIDDEN ) {
+        return false;
+    }
+    uint64_t keys[BOOK_SYMMETRIES] = { 0 };
+    bool occupied[BOARD_MAX_SIZE * BOARD_MAX_SIZE] = { false };
+    size_t limit = g->moves_count < w->moves ? g->moves_count : w->moves;
+    for ( size_t i = 0; i < limit; i++ ) {
+        const move* m = &g->moves[i];
+        //A loaded game may place a stone on an occupied intersection; the positions after it are not real
+        if ( occupied[ m->y * size + m->x ] ) {
+            break;
+        }
+        //A position with symmetries of its own has several smallest copies; the smallest move of them merges the moves they make the same
+        uint64_t key = smallest( keys );
+        unsigned short cell = USHRT_MAX;
+        for ( int s = 0; s < BOOK_SYMMETRIES; s++ ) {
+            unsigned short turned = transform( size, s, m->x, m->y );
+            if ( keys[s] == key && turned < cell ) {
+                cell = turned;
+            }
+        }
+
+        if ( 2 * ( w->count + 1 ) > w->capacity ) {
+            grow( w );
+        }
+        book_stat* stat = &w->stats[ stat_slot( w, key, cell ) ];
+        if ( stat->games == 0 ) {
+            stat->key = key;
+            stat->cell = cell;
+            w->count++;
+        }
+        stat->games++;
+        stat->wins += g->winner == m->stone;
+        stat->draws += g->winner == EMPTY_INTERSECTION;
+
+        occupied[ m->y * size + m->x ] = true;
+        for ( int s = 0; s < BOOK_SYMMETRIES; s++ ) {
+            keys[s] ^= stone_key( m->stone, transform( size, s, m->x, m->y ) );
+        }
+    }
+    return true;
+}
+
+uint32_t book_builder_close( book_builder* w, const char* path, uint32_t min_games )
+{
+    if ( w == NULL ) {
+        exit( NULL_POINTER_ERR );
+    }
+    if ( min_games == 0 ) {
+        min_games = 1;
+    }
+    uint32_t count = 0;
+    for ( size_t i = 0; i < w->capacity; i++ ) {
+        count += w->stats[i].games >= min_games;
+    }
+    //Keep the table at most half full so that the runs stay short
+    uint32_t slots = MIN_SLOTS;
+    while ( slots < 2 * ( uint64_t )count ) {
+        slots *= 2;
+    }
+    unsigned char* table = ( unsigned char * )calloc( slots, BOOK_ENTRY_SIZE );
+    if (table == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    for ( size_t i = 0; i < w->capacity; i++ ) {
+        const book_stat* stat = &w->stats[i];
+        if ( stat->games < min_games ) {
+            continue;
+        }
+        uint32_t slot = stat->key & ( slots - 1 );
+        while ( get_le( table + ( size_t )slot * BOOK_ENTRY_SIZE + 12, 4 ) != 0 ) {
+            slot = ( slot + 1 ) & ( slots - 1 );
+        }
+        unsigned char* entry = table + ( size_t )slot * BOOK_ENTRY_SIZE;
+        put_le( entry, stat->key, 8 );
+        put_le( entry + 8, stat->cell, 2 );
+        put_le( entry + 12, stat->games, 4 );
+        put_le( entry + 16, stat->wins, 4 );
+        put_le( entry + 20, stat->draws, 4 );
+    }
+
+    unsigned char header[BOOK_HEADER_SIZE] = { 0 };
+    memcpy( header, BOOK_MAGIC, 4 );
+    put_le( header + 4, BOOK_VERSION, 2 );
+    header[6] = w->size;
+    header[7] = w->type;
+    put_le( header + 8, w->moves, 2 );
+    put_le( header + 12, count, 4 );
+    put_le( header + 16, slots, 4 );
+    FILE* file = fopen( path, "wb" );
+    if ( file == NULL ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    if ( fwrite( header, 1, BOOK_HEADER_SIZE, file ) != BOOK_HEADER_SIZE ||
+         fwrite( table, BOOK_ENTRY_SIZE, slots, file ) != slots ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    if ( fclose( file ) != 0 ) {
+        exit( FILE_OUTPUT_ERR );
+    }
+    free( table );
+    free( w->stats );
+    free( w );
+    return count;
+}
+
+static uint64_t stone_key( unsigned char stone, unsigned short cell )
+{
+    //splitmix64 finalizer of the color and intersection
+    uint64_t z = BOOK_KEY_SEED + ( ( uint64_t )stone << 16 | cell ) * 0x9E3779B97F4A7C15ULL;
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+}
+
+static unsigned short transform( unsigned char size, int symmetry, unsigned char x, unsigned char y )
+{
+    const unsigned char last = size - 1;
+    unsigned char tx = x;
+    unsigned char ty = y;
+    switch ( symmetry ) {
+        case 1: tx = last - y; ty = x; break;        //Quarter turn
+        case 2: tx = last - x; ty = last - y; break; //Half turn
+        case 3: tx = y; ty = last - x; break;        //Three quarter turn
+        case 4: tx = last - x; ty = y; break;        //Reflection across the vertical middle line
+        case 5: tx = x; ty = last - y; break;        //Reflection across the horizontal middle line
+        case 6: tx = y; ty = x; break;               //Reflection across the main diagonal
+        case 7: tx = last - y; ty = last - x; break; //Reflection across the other diagonal
+    }
+    return ty * size + tx;
+}
+
+static uint64_t smallest( const uint64_t* keys )
+{
+    uint64_t key = keys[0];
+    for ( int s = 1; s < BOOK_SYMMETRIES; s++ ) {
+        if ( keys[s] < key ) {
+            key = keys[s];
+        }
+    }
+    return key;
+}
+
+static size_t stat_slot( const book_builder* w, uint64_t key, unsigned short cell )
+{
+    size_t slot = ( key ^ cell * 0x9E3779B97F4A7C15ULL ) & ( w->capacity - 1 );
+    while ( w->stats[slot].games != 0 && ( w->stats[slot].key != key || w->stats[slot].cell != cell ) ) {
+        slot = ( slot + 1 ) & ( w->capacity - 1 );
+    }
+    return slot;
+}
+
+static void grow( book_builder* w )
+{
+    book_stat* old = w->stats;
+    size_t old_capacity = w->capacity;
+    w->capacity *= 2;
+    w->stats = ( book_stat * )calloc( w->capacity, sizeof( book_stat ) );
+    if (w->stats == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    for ( size_t i = 0; i < old_capacity; i++ ) {
+        if ( old[i].games != 0 ) {
+            w->stats[ stat_slot( w, old[i].key, old[i].cell ) ] = old[i];
+        }
+    }
+    free( old );
+}
+
+static uint64_t get_le( const unsigned char* p, int bytes )
+{
+    uint64_t value = 0;
+    for ( int i = bytes - 1; i >= 0; i-- ) {
+        value = value << 8 | p[i];
+    }
+    return value;
+}
+
+static void put_le( unsigned char* p, uint64_t value, int bytes )
+{
+    for ( int i = 0; i < bytes; i++ ) {
+        p[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef _BOOK_H_
+#define _BOOK_H_
+#include "game.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#define BOOK_MAGIC "GMKO"
+#define BOOK_VERSION 1
+#define BOOK_HEADER_SIZE 24
+#define BOOK_ENTRY_SIZE 24
+#define BOOK_DEFAULT_MOVES 12
+#define BOOK_MAX_MOVES 1000
+#define BOOK_SYMMETRIES 8
+
+/*
+ * An opening book holds, for the positions of the first moves of many games, every move played from
+ * them and how those games ended. Positions that are rotations or reflections of each other share
+ * their entries: a position is stored under the smallest of the keys of its 8 symmetric copies, and
+ * its moves are turned the same way. All numbers are little-endian.
+ *
+ * Header (BOOK_HEADER_SIZE bytes):
+ *   magic "GMKO", version (2 bytes), board size, game type (1 byte each), moves per game (2 bytes),
+ *   reserved (2 bytes), number of entries (4 bytes), number of slots (4 bytes, a power of two), reserved (4 bytes)
+ * Hash table of slots, each BOOK_ENTRY_SIZE bytes:
+ *   position key (8 bytes), move as its intersection index y * size + x (2 bytes), reserved (2 bytes),
+ *   games (4 bytes), wins and draws of the player of the move (4 bytes each)
+ * An entry lives in the first slot with no games at or after its position key modulo the number
+ * of slots, wrapping around, so the moves of a position are found by reading on from there to the
+ * first slot with no games.
+ */
+
+/**
+ * A read-only book mapped into memory.
+ */
+typedef struct {
+    const unsigned char* data;
+    size_t length;
+    unsigned char size;
+    unsigned char type;
+    unsigned short moves;
+    uint32_t count;
+    uint32_t slots;
+    const unsigned char* entries;
+} book;
+
+/**
+ * A move of the book from the probed position, turned back to the orientation of that position.
+ */
+typedef struct {
+    unsigned char x;
+    unsigned char y;
+    uint32_t games;
+    uint32_t wins;
+    uint32_t draws;
+} book_move;
+
+/**
+ * One move of one position while a book is being built.
+ */
+typedef struct {
+    uint64_t key;
+    unsigned short cell;
+    uint32_t games;
+    uint32_t wins;
+    uint32_t draws;
+} book_stat;
+
+/**
+ * A book being built in memory from games, then written out at once.
+ */
+typedef struct {
+    unsigned char size;
+    unsigned char type;
+    unsigned short moves;
+    book_stat* stats;
+    size_t count;
+    size_t capacity;
+} book_builder;
+
+/**
+ * Maps a book into memory and checks its header. Prints an error and exits with FILE_INPUT_ERR if
+ * the file cannot be read or is not a valid book.
+ * @param path Path to the book.
+ * @return The newly opened book.
+ */
+book* book_open(const char* path);
+
+/**
+ * Unmaps a book and frees its memory.
+ * @param b The book to close.
+ */
+void book_close(book* b);
+
+/**
+ * Finds the moves played from the current position of a game. Takes a few microseconds: the position
+ * key of each symmetry is computed from the moves list and a single run of the table is read.
+ * @param b The book.
+ * @param g The game, of the board size and type of the book.
+ * @param moves Array where the moves are stored.
+ * @param max The length of the array.
+ * @return The number of moves stored, 0 if the position is not in the book or the game does not match it.
+ */
+int book_probe(const book* b, const game* g, book_move* moves, int max);
+
+/**
+ * Picks the book move of the current position: the one played in the most games, then the one
+ * that scored best, skipping moves that are occupied or forbidden.
+ * @param b The book.
+ * @param g The game.
+ * @param x Reference to the location where the horizontal coordinate of the move is stored.
+ * @param y Reference to the location where the vertical coordinate of the move is stored.
+ * @return True if the book has a move, false otherwise.
+ */
+bool book_choose(const book* b, const game* g, unsigned char* x, unsigned char* y);
+
+/**
+ * Creates an empty book in memory.
+ * @param size The board size of the games.
+ * @param type The game type of the games.
+ * @param moves The number of moves of each game to add, up to BOOK_MAX_MOVES.
+ * @return The newly created builder.
+ */
+book_builder* book_builder_create(unsigned char size, unsigned char type, unsigned short moves);
+
+/**
+ * Adds the first moves of a finished game to the book.
+ * @param w The builder.
+ * @param g The game.
+ * @return False if the game was skipped because of its board size or type, or because it has no result.
+ */
+bool book_add(book_builder* w, const game* g);
+
+/**
+ * Writes the moves played in at least the given number of games to a file, then frees the builder.
+ * Exits with FILE_OUTPUT_ERR if the file cannot be written.
+ * @param w The builder.
+ * @param path Path to the book, replaced if it exists.
+ * @param min_games The fewest games a move must have been played in to be kept.
+ * @return The number of entries written.
+ */
+uint32_t book_builder_close(book_builder* w, const char* path, uint32_t min_games);
+#endif
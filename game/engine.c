@@ -0,0 +1,528 @@
+#define _POSIX_C_SOURCE 200809L
+#include "engine.h"
+#include "board.h"
+#include "game.h"
+#include "lines.h"
+#include "pattern.h"
+#include "rules.h"
+#include <pthread.h>
+#include <time.h>
+#define INFINITE_SCORE ( 2 * ENGINE_WIN_SCORE )
+#define MAX_CELLS ( BOARD_MAX_SIZE * BOARD_MAX_SIZE )
+#define BRANCH_LIMIT 20
+#define NEIGHBORHOOD 2
+#define TIME_CHECK_NODES 1024
+#define WIN_THRESHOLD ( ENGINE_WIN_SCORE - 1000 )
+
+/**
+ * A move considered by the search, with its ordering score.
+ */
+typedef struct {
+    unsigned char x;
+    unsigned char y;
+    int score;
+} candidate;
+
+/**
+ * State of one running search. In a parallel search every thread has its own, with its own copy
+ * of the game, and abort points to the flag the main thread raises when it is done.
+ */
+typedef struct {
+    game* g;
+    engine_limits limits;
+    struct timespec start;
+    unsigned long nodes;
+    bool stopped;
+    bool* abort;
+    int id;
+    candidate moves[MAX_CELLS];
+    int count;
+    engine_result result;
+} search;
+
+/**
+ * Value of each pattern a move creates for the side playing it, and for the opponent if they played there instead.
+ * Overlines only show up in exact five tables, where they are forbidden and worth nothing.
+ */
+static const int attack_weights[NUM_PATTERNS] = { 0, 10, 100, 120, 1000, 1000, 10000, 0 };
+static const int defend_weights[NUM_PATTERNS] = { 0, 8, 80, 100, 800, 800, 5000, 0 };
+
+/**
+ * Returns the number of milliseconds since the search started.
+ * @param s The running search.
+ * @return The elapsed time in milliseconds.
+ */
+static unsigned int elapsed_ms( const search* s );
+
+/**
+ * Finds the moves worth searching for the side to move: empty intersections within NEIGHBORHOOD of a stone,
+ * ordered by the patterns they create for both colors. If the side to move can make a five, only that move
+ * is returned. If the opponent threatens a five, only the blocking moves are returned. Forbidden moves are skipped.
+ * Patterns and the evaluation are read from the line cache, which must be tracked.
+ * @param s The running search.
+ * @param moves Array of at least MAX_CELLS where the ordered moves are stored.
+ * @param eval Reference to the location where the static evaluation for the side to move is stored.
+ * @param win Reference to a flag set to true if the first move makes a five.
+ * @return The number of moves stored.
+ */
+static int generate( search* s, candidate* moves, int* eval, bool* win );
+
+/**
+ * Converts a score to be stored in the transposition table. Win and loss scores are made relative to
+ * the position instead of the root, so they stay correct when reached through another path.
+ * @param score The score relative to the root.
+ * @param ply The distance of the position from the root.
+ * @return The score to store.
+ */
+static int score_to_tt( int score, int ply );
+
+/**
+ * Converts a score read from the transposition table back to a score relative to the root.
+ * @param score The stored score.
+ * @param ply The distance of the position from the root.
+ * @return The score relative to the root.
+ */
+static int score_from_tt( int score, int ply );
+
+/**
+ * Moves the given move to the front of the list, keeping the order of the others.
+ * @param moves The ordered moves.
+ * @param count The number of moves.
+ * @param x The horizontal coordinate of the move to search first.
+ * @param y The vertical coordinate of the move to search first.
+ */
+static void move_to_front( candidate* moves, int count, unsigned char x, unsigned char y );
+
+/**
+ * Runs the iterative deepening loop over the root moves of the search and keeps the best move found in its result.
+ * Helper threads (id above 0) vary the first depth and the first move, keep deepening until the main thread
+ * raises the abort flag and never store partial iterations.
+ * @param s The search, with its root moves and result already filled in.
+ */
+static void search_root( search* s );
+
+/**
+ * Entry point of a helper thread of a parallel search.
+ * @param arg The search of the thread.
+ * @return NULL.
+ */
+static void* search_thread( void* arg );
+
+/**
+ * Searches the current position with alpha-beta pruning.
+ * @param s The running search.
+ * @param depth The remaining depth in moves.
+ * @param alpha The lower bound of the search window.
+ * @param beta The upper bound of the search window.
+ * @param ply The distance from the root in moves.
+ * @return The score of the position for the side to move.
+ */
+static int search_node( search* s, int depth, int alpha, int beta, int ply );
+
+bool engine_search( game* g, const engine_limits* limits, engine_result* result )
+{
+    search* s = ( search * )malloc( sizeof( search ) );
+    if (s == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    s->g = g;
+    s->limits = *limits;
+    s->nodes = 0;
+    s->stopped = false;
+    s->abort = NULL;
+    s->id = 0;
+    clock_gettime( CLOCK_MONOTONIC, &s->start );
+    
+    if ( g->state != GAME_STATE_PLAYING ) {
+        free( s );
+        return false;
+    }
+    //A known opening needs no search
+    if ( limits->book != NULL && book_choose( limits->book, g, &result->x, &result->y ) ) {
+        result->score = 0;
+        result->depth = 0;
+        result->nodes = 0;
+        result->time_ms = elapsed_ms( s );
+        free( s );
+        return true;
+    }
+    if ( limits->table != NULL ) {
+        tt_new_search( limits->table );
+    }
+    //Every node reads the line cache, which is far cheaper to keep up to date than to classify from scratch
+    bool tracking = g->tracking_lines;
+    if ( !tracking ) {
+        game_track_lines( g, true );
+    }
+    int eval;
+    bool win = false;
+    s->count = generate( s, s->moves, &eval, &win );
+    if ( s->count == 0 ) {
+        if ( !tracking ) {
+            game_track_lines( g, false );
+        }
+        free( s );
+        return false;
+    }
+    //Start from the best ordered move in case the first iteration runs out of time
+    s->result.x = s->moves[0].x;
+    s->result.y = s->moves[0].y;
+    s->result.score = win ? ENGINE_WIN_SCORE : eval;
+    s->result.depth = 0;
+    
+    if ( !win && s->count > 1 ) {
+        //Start from the best move of an earlier search of this position
+        tt_data entry;
+        if ( limits->table != NULL && tt_probe( limits->table, game_hash( g ), &entry ) ) {
+            move_to_front( s->moves, s->count, entry.x, entry.y );
+        }
+        if ( s->count > BRANCH_LIMIT ) {
+            s->count = BRANCH_LIMIT;
+        }
+        
+        //Lazy SMP: helpers search copies of the game and share what they learn through the table
+        int helpers = limits->threads > 1 && limits->table != NULL ? limits->threads - 1 : 0;
+        if ( helpers > ENGINE_MAX_THREADS ) {
+            helpers = ENGINE_MAX_THREADS;
+        }
+        search* workers[ENGINE_MAX_THREADS];
+        pthread_t threads[ENGINE_MAX_THREADS];
+        bool abort = false;
+        s->abort = &abort;
+        for ( int i = 0; i < helpers; i++ ) {
+            workers[i] = ( search * )malloc( sizeof( search ) );
+            if (workers[i] == NULL) {
+                fprintf(stderr, "ERROR: Failed to allocate memory\n");
+                exit(1);
+            }
+            *workers[i] = *s;
+            workers[i]->g = game_copy( g );
+            workers[i]->id = i + 1;
+            if ( pthread_create( &threads[i], NULL, search_thread, workers[i] ) != 0 ) {
+                fprintf(stderr, "ERROR: Failed to start search thread\n");
+                exit(1);
+            }
+        }
+        search_root( s );
+        __atomic_store_n( &abort, true, __ATOMIC_RELAXED );
+        for ( int i = 0; i < helpers; i++ ) {
+            pthread_join( threads[i], NULL );
+            //A helper that completed a deeper iteration knows better
+            if ( workers[i]->result.depth > s->result.depth ) {
+                s->result.x = workers[i]->result.x;
+                s->result.y = workers[i]->result.y;
+                s->result.score = workers[i]->result.score;
+                s->result.depth = workers[i]->result.depth;
+            }
+            s->nodes += workers[i]->nodes;
+            game_delete( workers[i]->g );
+            free( workers[i] );
+        }
+    }
+    if ( !tracking ) {
+        game_track_lines( g, false );
+    }
+    *result = s->result;
+    result->nodes = s->nodes;
+    result->time_ms = elapsed_ms( s );
+    free( s );
+    return true;
+}
+
+void engine_loop( game* g, unsigned char ai_stone, const engine_limits* limits )
+{
+    do {
+        board_print( g->board, true );
+        if ( g->stone == ai_stone ) {
+            engine_result result;
+            if ( !engine_search( g, limits, &result ) ) {
+                break;
+            }
+            game_place_stone( g, result.x, result.y );
+            //Switch players
+            if ( g->stone == BLACK_STONE ) {
+                g->stone = WHITE_STONE;
+            } else {
+                g->stone = BLACK_STONE;
+            }
+        } else {
+            game_update( g );
+        }
+    } while ( g->state == GAME_STATE_PLAYING );
+}
+
+static unsigned int elapsed_ms( const search* s )
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( now.tv_sec - s->start.tv_sec ) * 1000 + ( now.tv_nsec - s->start.tv_nsec ) / 1000000;
+}
+
+static int generate( search* s, candidate* moves, int* eval, bool* win )
+{
+    game* g = s->g;
+    board* b = g->board;
+    unsigned char own = g->stone;
+    unsigned char opponent = own == BLACK_STONE ? WHITE_STONE : BLACK_STONE;
+    bool own_exact = g->type == GAME_RENJU && own == BLACK_STONE;
+    *eval = 0;
+    
+    //Open in the middle of an empty board
+    if ( b->stones == 0 ) {
+        moves[0].x = b->size / 2;
+        moves[0].y = b->size / 2;
+        moves[0].score = 0;
+        return 1;
+    }
+    
+    //Grow the occupied bits of each row by NEIGHBORHOOD in every direction to find the nearby empty intersections
+    line_bits occupied[BOARD_MAX_SIZE];
+    for ( int y = 0; y < b->size; y++ ) {
+        occupied[y] = board_line( b, BLACK_STONE, AXIS_HORIZONTAL, 0, y, NULL ) | board_line( b, WHITE_STONE, AXIS_HORIZONTAL, 0, y, NULL );
+    }
+    line_bits row_mask = board_line_mask( b, AXIS_HORIZONTAL, 0, 0 );
+    //Only the rows near a stone can hold a candidate, which matters on large boards
+    bounds box;
+    board_bounds( b, NEIGHBORHOOD, &box );
+    
+    int count = 0;
+    int blocks = 0;
+    for ( int y = box.min_y; y <= box.max_y; y++ ) {
+        line_bits near = 0;
+        for ( int row = y - NEIGHBORHOOD; row <= y + NEIGHBORHOOD; row++ ) {
+            if ( row >= 0 && row < b->size ) {
+                for ( int shift = 0; shift <= NEIGHBORHOOD; shift++ ) {
+                    near |= occupied[row] << shift | occupied[row] >> shift;
+                }
+            }
+        }
+        near &= row_mask & ~occupied[y];
+        
+        while ( near ) {
+            unsigned char x = LINE_CTZ( near );
+            near &= near - 1;
+            
+            unsigned char own_patterns[NUM_AXES];
+            unsigned char opponent_patterns[NUM_AXES];
+            for ( unsigned char axis = 0; axis < NUM_AXES; axis++ ) {
+                own_patterns[axis] = lines_pattern( g->lines, x, y, own, axis );
+                opponent_patterns[axis] = lines_pattern( g->lines, x, y, opponent, axis );
+            }
+            int attack = 0;
+            int defend = 0;
+            bool threat = false;
+            bool block = false;
+            for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+                if ( own_patterns[axis] == PATTERN_FIVE ) {
+                    moves[0].x = x;
+                    moves[0].y = y;
+                    moves[0].score = attack_weights[PATTERN_FIVE];
+                    *win = true;
+                    return 1;
+                }
+                attack += attack_weights[ own_patterns[axis] ];
+                defend += defend_weights[ opponent_patterns[axis] ];
+                threat |= own_patterns[axis] >= PATTERN_OPEN_THREE;
+                block |= opponent_patterns[axis] == PATTERN_FIVE;
+            }
+            //Skip forbidden moves, only possible for black when the move makes a strong shape
+            if ( own_exact && threat && game_check_move( g, x, y ) == GAME_STATE_FORBIDDEN ) {
+                continue;
+            }
+            //Once the opponent threatens a five, only blocking moves are worth anything
+            if ( block && blocks == 0 ) {
+                count = 0;
+            }
+            if ( block || blocks == 0 ) {
+                blocks += block;
+                
+                //Insert in descending score order
+                int i = count++;
+                while ( i > 0 && moves[i - 1].score < attack + defend ) {
+                    moves[i] = moves[i - 1];
+                    i--;
+                }
+                moves[i].x = x;
+                moves[i].y = y;
+                moves[i].score = attack + defend;
+            }
+        }
+    }
+    //The counters add up the patterns of every empty intersection, candidate or not
+    for ( int pattern = 0; pattern < NUM_PATTERNS; pattern++ ) {
+        *eval += attack_weights[pattern] * ( ( int )g->lines->moves[own - 1][pattern] - ( int )g->lines->moves[opponent - 1][pattern] );
+    }
+    return count;
+}
+
+static void search_root( search* s )
+{
+    candidate* moves = s->moves;
+    int count = s->count;
+    unsigned char max_depth = s->limits.max_depth ? s->limits.max_depth : ENGINE_MAX_DEPTH;
+    unsigned char depth = 1;
+    if ( s->id > 0 ) {
+        //Spread the helpers over neighbouring depths and first moves so they do not all repeat the main search
+        depth += s->id % 2;
+        move_to_front( moves, count, moves[s->id % count].x, moves[s->id % count].y );
+    }
+    for ( ; depth <= max_depth; depth++ ) {
+        int alpha = -INFINITE_SCORE;
+        int best = -1;
+        for ( int i = 0; i < count; i++ ) {
+            //A move that cannot be made leaves nothing to take back
+            if ( !game_make_move( s->g, moves[i].x, moves[i].y ) ) {
+                continue;
+            }
+            int score = -search_node( s, depth - 1, -INFINITE_SCORE, -alpha, 1 );
+            game_unmake_move( s->g );
+            if ( s->stopped ) {
+                break;
+            }
+            if ( score > alpha ) {
+                alpha = score;
+                best = i;
+            }
+        }
+        //Keep the best move of this iteration, even a partial one, and search it first next time
+        if ( best >= 0 && ( s->id == 0 || !s->stopped ) ) {
+            move_to_front( moves, count, moves[best].x, moves[best].y );
+            s->result.x = moves[0].x;
+            s->result.y = moves[0].y;
+            s->result.score = alpha;
+            s->result.depth = depth;
+            if ( s->limits.table != NULL && !s->stopped ) {
+                tt_data stored = { score_to_tt( alpha, 0 ), depth, TT_BOUND_EXACT, moves[0].x, moves[0].y };
+                tt_store( s->limits.table, game_hash( s->g ), &stored );
+            }
+        }
+        //Stop when out of time, when a forced result is found, or when the next iteration cannot finish
+        if ( s->stopped || alpha >= ENGINE_WIN_SCORE - ENGINE_MAX_DEPTH || alpha <= -ENGINE_WIN_SCORE + ENGINE_MAX_DEPTH ) {
+            break;
+        }
+        if ( s->id == 0 && s->limits.time_ms && elapsed_ms( s ) * 2 > s->limits.time_ms ) {
+            break;
+        }
+    }
+}
+
+static void* search_thread( void* arg )
+{
+    search_root( ( search * )arg );
+    return NULL;
+}
+
+static int search_node( search* s, int depth, int alpha, int beta, int ply )
+{
+    s->nodes++;
+    if ( s->nodes % TIME_CHECK_NODES == 0 ) {
+        if ( s->limits.time_ms && elapsed_ms( s ) >= s->limits.time_ms ) {
+            s->stopped = true;
+        } else if ( s->abort != NULL && __atomic_load_n( s->abort, __ATOMIC_RELAXED ) ) {
+            s->stopped = true;
+        }
+    }
+    if ( s->stopped ) {
+        return 0;
+    }
+    
+    //Reuse what an earlier visit of this position learned
+    uint64_t key = game_hash( s->g );
+    tt_data entry;
+    bool hit = s->limits.table != NULL && tt_probe( s->limits.table, key, &entry );
+    if ( hit && entry.depth >= depth ) {
+        int score = score_from_tt( entry.score, ply );
+        if ( entry.bound == TT_BOUND_EXACT || ( entry.bound == TT_BOUND_LOWER && score >= beta ) || ( entry.bound == TT_BOUND_UPPER && score <= alpha ) ) {
+            return score;
+        }
+    }
+    
+    candidate moves[MAX_CELLS];
+    int eval;
+    bool win = false;
+    int count = generate( s, moves, &eval, &win );
+    if ( win ) {
+        return ENGINE_WIN_SCORE - ply;
+    } else if ( count == 0 ) {
+        return 0;
+    } else if ( depth <= 0 ) {
+        return eval;
+    }
+    
+    if ( hit ) {
+        move_to_front( moves, count, entry.x, entry.y );
+    }
+    if ( count > BRANCH_LIMIT ) {
+        count = BRANCH_LIMIT;
+    }
+    int original_alpha = alpha;
+    int best = -INFINITE_SCORE;
+    int best_index = 0;
+    for ( int i = 0; i < count; i++ ) {
+        //A move that cannot be made leaves nothing to take back
+        if ( !game_make_move( s->g, moves[i].x, moves[i].y ) ) {
+            continue;
+        }
+        int score = -search_node( s, depth - 1, -beta, -alpha, ply + 1 );
+        game_unmake_move( s->g );
+        if ( s->stopped ) {
+            return 0;
+        }
+        if ( score > best ) {
+            best = score;
+            best_index = i;
+        }
+        if ( best > alpha ) {
+            alpha = best;
+        }
+        if ( alpha >= beta ) {
+            break;
+        }
+    }
+    
+    if ( s->limits.table != NULL ) {
+        tt_data stored = { score_to_tt( best, ply ), depth, TT_BOUND_EXACT, moves[best_index].x, moves[best_index].y };
+        if ( best <= original_alpha ) {
+            stored.bound = TT_BOUND_UPPER;
+        } else if ( best >= beta ) {
+            stored.bound = TT_BOUND_LOWER;
+        }
+        tt_store( s->limits.table, key, &stored );
+    }
+    return best;
+}
+
+static int score_to_tt( int score, int ply )
+{
+    if ( score >= WIN_THRESHOLD ) {
+        return score + ply;
+    } else if ( score <= -WIN_THRESHOLD ) {
+        return score - ply;
+    }
+    return score;
+}
+
+static int score_from_tt( int score, int ply )
+{
+    if ( score >= WIN_THRESHOLD ) {
+        return score - ply;
+    } else if ( score <= -WIN_THRESHOLD ) {
+        return score + ply;
+    }
+    return score;
+}
+
+static void move_to_front( candidate* moves, int count, unsigned char x, unsigned char y )
+{
+    for ( int i = 0; i < count; i++ ) {
+        if ( moves[i].x == x && moves[i].y == y ) {
+            candidate chosen = moves[i];
+            for ( ; i > 0; i-- ) {
+                moves[i] = moves[i - 1];
+            }
+            moves[0] = chosen;
+            return;
+        }
+    }
+}
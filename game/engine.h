@@ -0,0 +1,59 @@
+#ifndef _ENGINE_H_
+#define _ENGINE_H_
+#include "game.h"
+#include "tt.h"
+#include "book.h"
+#include <stdbool.h>
+#define ENGINE_MAX_DEPTH 32
+#define ENGINE_DEFAULT_TIME 1000
+#define ENGINE_WIN_SCORE 1000000
+#define ENGINE_MAX_THREADS 256
+
+/**
+ * Limits for a single search. A zero field means no limit of that kind.
+ * table is the transposition table to use, or NULL to search without one.
+ * threads is the number of threads searching in parallel through the table. With 0 or 1 thread,
+ * or without a table, the search runs on the calling thread alone and is deterministic.
+ * book is an opening book whose move is played without searching while the position is in it, or NULL.
+ */
+typedef struct {
+    unsigned char max_depth;
+    unsigned int time_ms;
+    tt* table;
+    unsigned short threads;
+    const book* book;
+} engine_limits;
+
+/**
+ * The outcome of a search: the chosen move and what the search learned about it.
+ */
+typedef struct {
+    unsigned char x;
+    unsigned char y;
+    int score;
+    unsigned char depth;
+    unsigned long nodes;
+    unsigned int time_ms;
+} engine_result;
+
+/**
+ * Picks a move for the side to move with an iterative deepening alpha-beta search.
+ * Moves are made and unmade on the given game with game_make_move and game_unmake_move,
+ * so the position is restored before returning. Nothing is printed. The line cache of the game
+ * is tracked during the search, since candidates and evaluations are read from it.
+ * @param g The game to search. Must be in the GAME_STATE_PLAYING state.
+ * @param limits The depth and time budget of the search.
+ * @param result Reference to the location where the chosen move and search statistics are stored.
+ * @return True if a move was found, false if the game is over or no legal move is left.
+ */
+bool engine_search(game* g, const engine_limits* limits, engine_result* result);
+
+/**
+ * Repeats printing the board and asking for a move until the game ends, like game_loop,
+ * except that the moves of the given color are picked by engine_search.
+ * @param g The current game.
+ * @param ai_stone The color played by the engine (BLACK_STONE or WHITE_STONE).
+ * @param limits The depth and time budget of each engine move.
+ */
+void engine_loop(game* g, unsigned char ai_stone, const engine_limits* limits);
+#endif
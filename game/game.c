@@ -1,162 +1,144 @@
+#define _POSIX_C_SOURCE 200809L
 #include "game.h"
 #include "error-codes.h"
 #include "board.h"
-
-
-
-
+#include "pattern.h"
+#include "rules.h"
+#include <time.h>
 
 /**
- * Checks if the area on the given board surrounding a given coordinate and finds the longest continuous 
- * line of stones it connects to. Also determines the number of open fours surrounding the given location.
- * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param open_fours A counter that is incremented each time an open four is found at the given coordinates.
+ * Places a stone of the current color, saves the move and updates the game state and winner.
+ * Never prints and does not switch players.
+ * @param g The game in which the move should be made.
+ * @param x The horizontal coordinate of the move, assumed to be an empty intersection.
+ * @param y The vertical coordinate of the move, assumed to be an empty intersection.
+ * @param draw Reference to a flag set to true if the move filled the board without ending the game.
+ * @return False if the moves list is full, in which case nothing is changed.
  */
-static unsigned char find_max_line( const game* g, const unsigned char x, const unsigned char y, unsigned char* open_fours );
+static bool apply_move( game* g, unsigned char x, unsigned char y, bool* draw );
 
 /**
- * Determines the number of stones above the given coordinates that are the same color as the current stone.
- * Also determines if the last stone of a matching color is followed by an empty intersection.
- * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param pos External counter of the number of matching stones found.
- * @return True if the last matching stone is followed by an empty intersection, false otherwise.
+ * Returns whether a replay prints the position after the given move.
+ * @param options The replay options.
+ * @param number The number of the move, starting at 1.
+ * @param num_moves The number of moves in the game.
+ * @return True if the move is shown.
  */
-static bool count_north( const game* g, unsigned char x, unsigned char y, unsigned char* pos );
+static bool replay_shows( const replay_options* options, size_t number, size_t num_moves );
 
 /**
- * Determines the number of stones below the given coordinates that are the same color as the current stone.
- * Also determines if the last stone of a matching color is followed by an empty intersection.
+ * Checks that the moves list has room for one more move. It holds a move per intersection, which is only
+ * too few for a loaded game that placed several stones on the same intersection.
  * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param pos External counter of the number of matching stones found.
- * @return True if the last matching stone is followed by an empty intersection, false otherwise.
+ * @return True if there is room.
  */
-static bool count_south( const game* g, unsigned char x, unsigned char y, unsigned char* neg );
-
-/**
- * Determines the number of stones left of the given coordinates that are the same color as the current stone.
- * Also determines if the last stone of a matching color is followed by an empty intersection.
- * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param pos External counter of the number of matching stones found.
- * @return True if the last matching stone is followed by an empty intersection, false otherwise.
- */
-static bool count_east( const game* g, unsigned char x, unsigned char y, unsigned char* pos );
-
-/**
- * Determines the number of stones right of the given coordinates that are the same color as the current stone.
- * Also determines if the last stone of a matching color is followed by an empty intersection.
- * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param pos External counter of the number of matching stones found.
- * @return True if the last matching stone is followed by an empty intersection, false otherwise.
- */
-static bool count_west( const game* g, unsigned char x, unsigned char y, unsigned char* pos );
-
-/**
- * Determines the number of stones above and right of the given coordinates that are the same color as the current stone.
- * Also determines if the last stone of a matching color is followed by an empty intersection.
- * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param pos External counter of the number of matching stones found.
- * @return True if the last matching stone is followed by an empty intersection, false otherwise.
- */
-static bool count_northeast( const game* g, unsigned char x, unsigned char y, unsigned char* pos );
-
-/**
- * Determines the number of stones below and left the given coordinates that are the same color as the current stone.
- * Also determines if the last stone of a matching color is followed by an empty intersection.
- * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param pos External counter of the number of matching stones found.
- * @return True if the last matching stone is followed by an empty intersection, false otherwise.
- */
-static bool count_southeast( const game* g, unsigned char x, unsigned char y, unsigned char* neg );
-
-/**
- * Determines the number of stones above and left of the given coordinates that are the same color as the current stone.
- * Also determines if the last stone of a matching color is followed by an empty intersection.
- * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param pos External counter of the number of matching stones found.
- * @return True if the last matching stone is followed by an empty intersection, false otherwise.
- */
-static bool count_northwest( const game* g, unsigned char x, unsigned char y, unsigned char* pos );
-
-/**
- * Determines the number of stones below and left of the given coordinates that are the same color as the current stone.
- * Also determines if the last stone of a matching color is followed by an empty intersection.
- * @param g The game to check.
- * @param x The horizontal coordinate of the last stone placed.
- * @param y The vertical coordinate of the last stone placed.
- * @param pos External counter of the number of matching stones found.
- * @return True if the last matching stone is followed by an empty intersection, false otherwise.
- */
-static bool count_southwest( const game* g, unsigned char x, unsigned char y, unsigned char* pos );
-
-/**
- * Determines if the given coordinates are within the boundaries of the board.
- * @param g The game to check.
- * @param x The horizontal coordinate of the location to check.
- * @param y The vertical coordinate of the location to check.
- * @return True if the coordinates are on the board, false otherwise.
- */
-static bool in_bounds( const game* g, unsigned char x, unsigned char y );
+static bool has_room( const game* g );
 
 game* game_create(unsigned char board_size, unsigned char game_type) 
 {
-    game *g = ( game *)malloc( sizeof( game ) );
-    if (g == NULL) {
+    unsigned char status;
+    game* g = game_new( board_size, game_type, &status );
+    if ( g == NULL && status == MEMORY_ERR ) {
         fprintf(stderr, "ERROR: Failed to allocate memory\n");
         exit(1);
+    } else if ( g == NULL ) {
+        exit( status );
     }
-    g->board = board_create( board_size );
-    
-    //Bounds check type and assign
-    if ( game_type != GAME_FREESTYLE && game_type != GAME_RENJU ) {
-        exit ( INPUT_ERR );
-    }
+    return g;
+}
+
+game* game_new(unsigned char board_size, unsigned char game_type, unsigned char* status) 
+{
+    //Bounds check size and type
+    if ( !board_size_valid( board_size ) ) {
+        *status = BOARD_SIZE_ERR;
+        return NULL;
+    } else if ( game_type != GAME_FREESTYLE && game_type != GAME_RENJU ) {
+        *status = INPUT_ERR;
+        return NULL;
+    }
+    void* memory = malloc( game_footprint( board_size ) );
+    if (memory == NULL) {
+        *status = MEMORY_ERR;
+        return NULL;
+    }
+    *status = SUCCESS;
+    return game_init( memory, board_size, game_type );
+}
+
+size_t game_footprint(unsigned char board_size)
+{
+    return BOARD_ALIGN_UP( sizeof( game ) ) + board_footprint( board_size ) +
+           BOARD_ALIGN_UP( board_size * board_size * sizeof( move ) ) + lines_footprint( board_size );
+}
+
+game* game_init(void* memory, unsigned char board_size, unsigned char game_type)
+{
+    //The game, then its board, then room for a move on every intersection, then the line cache
+    game* g = ( game * )memory;
+    g->board = board_init( ( char * )memory + BOARD_ALIGN_UP( sizeof( game ) ), board_size );
+    g->moves = ( move * )( ( char * )g->board + board_footprint( board_size ) );
+    g->moves_capacity = board_size * board_size;
+    g->lines = lines_init( ( char * )g->moves + BOARD_ALIGN_UP( board_size * board_size * sizeof( move ) ), board_size,
+                           game_type == GAME_RENJU );
+    g->tracking_lines = false;
     g->type = game_type;
-    
-    
+    g->kernels = rules_select( board_size, game_type );
+    pattern_init();
+    game_reset( g );
+    return g;
+}
+
+void game_reset(game* g)
+{
+    board_reset( g->board );
     g->stone = BLACK_STONE;
     g->state = GAME_STATE_PLAYING;
     g->winner = EMPTY_INTERSECTION;
-    g->moves = ( move * )malloc( INITIAL_CAPACITY * sizeof( move ) );
-    if (g->moves == NULL) {
-        fprintf(stderr, "ERROR: Failed to allocate memory\n");
-        exit(1);
-    }
     g->moves_count = 0;
-    g->moves_capacity = INITIAL_CAPACITY;
-    return g;
+    if ( g->tracking_lines ) {
+        lines_rebuild( g->lines, g->board );
+    }
+}
+
+void game_track_lines(game* g, bool on)
+{
+    if ( on ) {
+        lines_rebuild( g->lines, g->board );
+    }
+    g->tracking_lines = on;
 }
 
 void game_delete(game* g) {
     if (g == NULL ) {
         exit( NULL_POINTER_ERR );
     }
-    board_delete( g->board );
-    free( g->moves );
+    //The board and moves list live in the same block as the game
     free( g );
 }
 
+game* game_copy( const game* g )
+{
+    game* copy = game_create( g->board->size, g->type );
+    board_assign( copy->board, g->board );
+    copy->stone = g->stone;
+    copy->state = g->state;
+    copy->winner = g->winner;
+    memcpy( copy->moves, g->moves, g->moves_count * sizeof( move ) );
+    copy->moves_count = g->moves_count;
+    if ( g->tracking_lines ) {
+        lines_assign( copy->lines, g->lines );
+        copy->tracking_lines = true;
+    }
+    return copy;
+}
+
 bool game_update(game* g) 
 {
     bool convert_success = false;
-    unsigned char* x = ( unsigned char* )malloc( sizeof( unsigned char ) );
-    unsigned char* y = ( unsigned char* )malloc( sizeof( unsigned char ) );
-    char* formal_coord = ( char* )malloc( 2 * sizeof( char ) );
+    unsigned char x;
+    unsigned char y;
+    char formal_coord[16];
     bool stone_placed = false;
     do {
         //Print message
@@ -171,24 +153,26 @@ bool game_update(game* g)
         
             //Scan input and check for EOF
             int scan;
-            scan = scanf( " %s", formal_coord );
+            scan = scanf( " %15s", formal_coord );
             
             if ( scan == EOF ) {
                 g->state = GAME_STATE_STOPPED;
                 printf( "The game is stopped.\n" );
                 return false;
             }
+            //The prompt and the echoed move
+            board_printed_below( g->board, 1 );
         
-        convert_success = board_coord( g->board, formal_coord, x, y );
+        convert_success = board_coord( g->board, formal_coord, &x, &y );
         
         if ( convert_success == SUCCESS ) {
-            stone_placed = game_place_stone( g, *x, *y );
+            stone_placed = game_place_stone( g, x, y );
         } else {
             printf( "The coordinate you entered is invalid, please try again.\n" );
+            board_printed_below( g->board, 1 );
         }
         
     } while ( !stone_placed );
-    free( formal_coord );
     
     //Switch players
         if ( g->stone == BLACK_STONE ) {
@@ -217,26 +201,50 @@ void game_resume(game* g)
     }
 }
 
-void game_replay(game* g)
+void game_replay(game* g, const replay_options* options)
 {
     game* replay = game_create( g->board->size, g->type );
+    replay->board->diff = options->diff;
     
-    unsigned char moveCounter = 0;
-    unsigned char g_num_moves = ( g->moves_count / sizeof( move ) );
+    size_t g_num_moves = g->moves_count;
+    bool shown = false;
+    struct timespec delay = { options->delay_ms / 1000, ( options->delay_ms % 1000 ) * 1000000L };
 
-    while ( moveCounter < g_num_moves ) {
-        
-        
-        
-        //call game_place_stone to receive message for next move if it exists
+    for ( size_t moveCounter = 0; moveCounter < g_num_moves; moveCounter++ ) {
         unsigned char x = g->moves[moveCounter].x;
         unsigned char y = g->moves[moveCounter].y;
         
-        game_place_stone( replay, x, y ); //Need to put games messages here
-        
-        //print the board unless game end conditions are met
-        if ( replay->state != GAME_STATE_FORBIDDEN && replay->state != GAME_STATE_FINISHED ) {
-            board_print ( replay->board, true );
+        if ( !replay_shows( options, moveCounter + 1, g_num_moves ) ) {
+            //Play the move without printing, skipping an occupied intersection like game_place_stone
+            bool draw;
+            if ( board_get( replay->board, x, y ) == EMPTY_INTERSECTION ) {
+                apply_move( replay, x, y, &draw );
+            }
+        } else {
+            //call game_place_stone to receive message for next move if it exists
+            game_place_stone( replay, x, y ); //Need to put games messages here
+            
+            //print the board unless game end conditions are met
+            if ( replay->state != GAME_STATE_FORBIDDEN && replay->state != GAME_STATE_FINISHED ) {
+                board_print ( replay->board, true );
+            }
+            
+            unsigned int lines = 0;
+            if ( moveCounter == g_num_moves - 1 && g->state != GAME_STATE_FORBIDDEN && g->state != GAME_STATE_FINISHED ) {
+                printf( "The game is stopped.\n" );
+                lines++;
+            }
+            
+            //print moves so far, which grow past the bottom of the screen in long games
+            lines += print_moves( replay );
+            board_printed_below( replay->board, lines );
+            shown = true;
+            
+            //wait before the next shown move
+            if ( options->delay_ms > 0 ) {
+                fflush( stdout );
+                nanosleep( &delay, NULL );
+            }
         }
         
         //Switch players
@@ -245,33 +253,38 @@ void game_replay(game* g)
         } else {
             replay->stone = BLACK_STONE;
         }
-        
-        if ( moveCounter == g_num_moves - 1 && g->state != GAME_STATE_FORBIDDEN && g->state != GAME_STATE_FINISHED ) {
-            printf( "The game is stopped.\n" );
-        }
-        
-        //print moves so far
-        print_moves( replay );
-        
-        //wait 1 second
-        #ifndef _NOSLEEP
-        sleep(1);
-        #endif
-        moveCounter++;
     }  //should call last move and print game end message
     
-    //End on newline if the last stone was black
-    if ( g->moves[g_num_moves - 1].stone == BLACK_STONE ) {
+    //End on newline if the last stone printed was black
+    if ( shown && replay->moves_count > 0 && replay->moves[ replay->moves_count - 1 ].stone == BLACK_STONE ) {
         printf( "\n" );
     }
+    game_delete( replay );
+}
+
+static bool replay_shows( const replay_options* options, size_t number, size_t num_moves )
+{
+    if ( number < options->seek ) {
+        return false;
+    } else if ( options->final_only ) {
+        return number == num_moves;
+    } else if ( options->selected != NULL ) {
+        for ( size_t i = 0; i < options->num_selected; i++ ) {
+            if ( options->selected[i] == number ) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return true;
 }
 
-void print_moves( game* replay )
+unsigned int print_moves( game* replay )
 {
-    unsigned char num_moves = ( replay->moves_count / sizeof( move ) );
     unsigned char stone = BLACK_STONE;
+    unsigned int lines = 1;
     printf( "Moves:\n" );
-    for ( int i = 0; i < num_moves; i++ ) {
+    for ( size_t i = 0; i < replay->moves_count; i++ ) {
         
         stone = replay->moves[i].stone;
         unsigned char x = replay->moves[i].x;
@@ -284,17 +297,16 @@ void print_moves( game* replay )
             exit( STONE_TYPE_ERR );
         }
         
-        char* formal_coord = ( char* )malloc( 4 * sizeof( char ) );
-        formal_coord[4] = '\0';
-        
+        char formal_coord[BOARD_COORD_LENGTH];
         board_formal_coord( replay->board, x, y, formal_coord );
         printf( "%3s", formal_coord );
-        free( formal_coord );
         if ( stone == WHITE_STONE ) {
             printf( "\n" );
+        } else {
+            lines++;
         }
     }
-    
+    return lines;
 }
         
 bool game_place_stone(game* g, unsigned char x, unsigned char y)
@@ -303,58 +315,25 @@ bool game_place_stone(game* g, unsigned char x, unsigned char y)
     unsigned char current_occupant = board_get( g->board, x, y);
     if ( current_occupant != 0 ) {
         printf( "There is already a stone at the coordinate you entered, please try again.\n" );
+        board_printed_below( g->board, 1 );
         return false;
     }
     //Move will be logged, even if invalid
-    //place stone in grid
-    board_set( g->board, x, y, g->stone );
-    //Save game
-    save_move( g, x, y );
-    
-    unsigned char open_four_count = 0;
-    unsigned char max_line = find_max_line( g, x, y, &open_four_count );
-    
-        //Check for a winner; If freestyle: 5 in a row of one color
-        //If renju: Black wins if an exact five is created
-        //          White wins if a five or overline is created, with no restrictions.
-            //CHECKING THE POSSIBLE WIN SCENARIO
-            if ( g->type == GAME_RENJU && max_line == FIVE_IN_A_ROW ) {
-                //Enforce rules for black
-                if ( g->stone == BLACK_STONE ) {
-                    //Fours are allowed but no overline
-                    if ( max_line > FIVE_IN_A_ROW ) {
-                        g->state = GAME_STATE_FORBIDDEN;
-                    } else {
-                        g->state = GAME_STATE_FINISHED;
-                    }
-                } else { //Enforce rules for white, no restrictions
-                    g->state = GAME_STATE_FINISHED;
-                }
-            } else if ( g->type == GAME_FREESTYLE && max_line >= FIVE_IN_A_ROW ) { //WIN SCENARIO
-                g->state = GAME_STATE_FINISHED;
-            } else if ( g->type == GAME_RENJU ) { //CHECKING THE NON-WIN Scenario
-                //If the game is renju, check if the move creates one overline, or 2 open fours with no overline
-                //If forbidden move is made, change the game state 
-                if ( open_four_count > MAX_OPEN_FOURS || max_line >= FIVE_IN_A_ROW ) {
-                    g->state = GAME_STATE_FORBIDDEN;
-                }
-            }     
-                
-    
-        //Check if the move to make is forbidden
-        //Check for a full board, i.e. a draw
-        bool draw = board_is_full( g->board );
+    bool draw;
+    if ( !apply_move( g, x, y, &draw ) ) {
+        printf( "There is no room left to record a move, the game cannot go on.\n" );
+        board_printed_below( g->board, 1 );
+        return false;
+    }
         
     //Prompt player if game state has changed
     if ( g->state == GAME_STATE_FORBIDDEN ) {
         if ( g->stone == WHITE_STONE ) {
             board_print( g->board, true );
             printf( "Game concluded, white made a forbidden move, black won.\n" );
-            g->winner = BLACK_STONE;
         } else {
             board_print( g->board, true );
             printf( "Game concluded, black made a forbidden move, white won.\n" );
-            g->winner = WHITE_STONE;
         }
     } else if ( g->state == GAME_STATE_FINISHED && draw ) {
         board_print( g->board, true );
@@ -363,352 +342,162 @@ bool game_place_stone(game* g, unsigned char x, unsigned char y)
         if ( g->stone == WHITE_STONE ) { //White wins
             board_print( g->board, true );
             printf( "Game concluded, white won.\n" );
-            g->winner = WHITE_STONE;
         } else { //Black wins
             board_print( g->board, true );
             printf( "Game concluded, black won.\n" );
-            g->winner = BLACK_STONE;
         }
     }
     return true;
 }
 
-static unsigned char find_max_line( const game* g, const unsigned char x, const unsigned char y, unsigned char* open_fours ) 
+bool game_make_move( game* g, unsigned char x, unsigned char y )
 {
-    //Create two pinters for either side of the current stone
-    unsigned char neg = 0;
-    unsigned char pos = 0;
-    bool open_neg = false;
-    bool open_pos = false;
-    unsigned char current_line = 0;
-    unsigned char max_line = 0;
-    
-    //Check both sides of the current location in North-South Directions
-    open_pos = count_north( g, x, y, &pos );
-    open_neg = count_south( g, x, y, &neg );
-    
-    //Add returned values from both sides and compare to max
-    current_line = pos + neg + 1;
-    if ( current_line >= max_line ) {
-        max_line = current_line;
-    }
-    //Check for an open four and increment counter if so
-    if ( current_line == FOUR_IN_A_ROW && open_neg && open_pos ) {
-        (*open_fours)++;
-    }
-        
-    
-    //Check both sides of the current location in East-West Directions
-    //Reset neg and pos and bools
-    neg = 0;
-    pos = 0;
-    open_neg = false;
-    open_pos = false;
-    
-    open_pos = count_east( g, x, y, &pos );
-    open_neg = count_west( g, x, y, &neg );
-    
-    //Add returned values from both sides and compare to max
-    current_line = pos + neg + 1;
-    if ( current_line >= max_line ) {
-        max_line = current_line;
-    }
-    //Check for an open four and increment counter if so
-    if ( current_line == FOUR_IN_A_ROW && open_neg && open_pos ) {
-        (*open_fours)++;
-    }
-    //Check both sides of the current location in NE-SW directions
-    neg = 0;
-    pos = 0;
-    open_neg = false;
-    open_pos = false;
-    
-    open_pos = count_northwest( g, x, y, &pos );
-    open_neg = count_southeast( g, x, y, &neg );
-    
-    //Add returned values from both sides and compare to max
-    current_line = pos + neg + 1;
-    if ( current_line >= max_line ) {
-        max_line = current_line;
+    if ( g->state != GAME_STATE_PLAYING || x >= g->board->size || y >= g->board->size ) {
+        return false;
+    } else if ( g->board->grid[ BOARD_INDEX( g->board, x, y ) ] != EMPTY_INTERSECTION ) {
+        return false;
     }
-    //Check for an open four and increment counter if so
-    if ( current_line == FOUR_IN_A_ROW && open_neg && open_pos ) {
-        (*open_fours)++;
+    bool draw;
+    if ( !apply_move( g, x, y, &draw ) ) {
+        return false;
     }
     
-    //Check both sides of the current location in NW-SE directions
-    neg = 0;
-    pos = 0;
-    open_neg = false;
-    open_pos = false;
-    
-    open_pos = count_northeast( g, x, y, &pos );
-    open_neg = count_southwest( g, x, y, &neg );
-    
-    //Add returned values from both sides and compare to max
-    current_line = pos + neg + 1;
-    if ( current_line >= max_line ) {
-        max_line = current_line;
-    }
-    //Check for an open four and increment counter if so
-    if ( current_line == FOUR_IN_A_ROW && open_neg && open_pos ) {
-        (*open_fours)++;
+    //Switch players
+    if ( g->stone == BLACK_STONE ) {
+        g->stone = WHITE_STONE;
+    } else {
+        g->stone = BLACK_STONE;
     }
-    
-    return max_line;
+    return true;
 }
 
-static bool count_north( const game* g, unsigned char x, unsigned char y, unsigned char* pos )
+bool game_unmake_move( game* g )
 {
-    bool open_ended = false;
-    //Determine if traversing north violates boundaries
-    bool on_board = in_bounds(g, x, y + 1 );
-    if ( !on_board ) {
-        return open_ended;
-    }
-    //While the current stone matches the stone above it, increment counter and increment coordinates
-    bool stone_match = g->stone == board_get( g->board, x, y + 1 );
-    
-    while ( stone_match ) {
-        (*pos)++;
-        y++;
-        on_board = in_bounds(g, x, y + 1 );
-        if ( on_board ) {
-            stone_match = g->stone == board_get( g->board, x, y + 1 );
-        } else {
-            break;
-        }
+    if ( g->moves_count == 0 ) {
+        return false;
     }
-    //Check if there's an empty intersection at the end
-    if ( on_board ) {
-        open_ended = board_get( g->board, x, y + 1 ) == EMPTY_INTERSECTION;
+    //Take the last move off the list and the board, and give its player the turn back
+    g->moves_count--;
+    move last = g->moves[ g->moves_count ];
+    board_set( g->board, last.x, last.y, EMPTY_INTERSECTION );
+    if ( g->tracking_lines ) {
+        lines_update( g->lines, g->board, last.x, last.y, last.stone );
     }
-    return open_ended;
+    g->stone = last.stone;
+    g->state = GAME_STATE_PLAYING;
+    g->winner = EMPTY_INTERSECTION;
+    return true;
 }
 
-static bool count_south( const game* g, unsigned char x, unsigned char y, unsigned char* neg )
+static bool apply_move( game* g, unsigned char x, unsigned char y, bool* draw )
 {
-    bool open_ended = false;
-    //Determine if traversing violates boundaries
-    bool on_board = in_bounds(g, x, y - 1 );
-    if ( !on_board ) {
-        return open_ended;
-    }
-    //While the current stone matches the stone next to it, increment counter and increment coordinates
-    bool stone_match = g->stone == board_get( g->board, x, y - 1 );
-    
-    while ( stone_match ) {
-        (*neg)++;
-        y--;
-        on_board = in_bounds(g, x, y - 1 );
-        if ( on_board ) {
-            stone_match = g->stone == board_get( g->board, x, y - 1 );
-        } else {
-            break;
-        }
-    }
-    //Check if there's an empty intersection at the end
-    if ( on_board ) {
-        open_ended = board_get( g->board, x, y - 1 ) == EMPTY_INTERSECTION;
+    *draw = false;
+    if ( !has_room( g ) ) {
+        return false;
     }
-    return open_ended;
-}
-
-static bool count_west( const game* g, unsigned char x, unsigned char y, unsigned char* neg )
-{
-    
-    bool open_ended = false;
-    //Determine if traversing violates boundaries
-    bool on_board = in_bounds(g, x - 1, y );
-    if ( !on_board ) {
-        return open_ended;
+    //Check for a winner or a forbidden move before the stone is placed
+    unsigned char state = game_check_move( g, x, y );
+    board_set( g->board, x, y, g->stone );
+    if ( g->tracking_lines ) {
+        lines_update( g->lines, g->board, x, y, EMPTY_INTERSECTION );
     }
-    //While the current stone matches the stone next to it, increment counter and increment coordinates
-    bool stone_match = g->stone == board_get( g->board, x - 1, y );
+    save_move( g, x, y );
     
-    while ( stone_match ) {
-        (*neg)++;
-        x--;
-        on_board = in_bounds(g, x - 1, y );
-        if ( on_board ) {
-            stone_match = g->stone == board_get( g->board, x - 1, y );
-        } else {
-            break;
-        }
+    if ( state == GAME_STATE_FORBIDDEN ) {
+        g->state = state;
+        g->winner = g->stone == BLACK_STONE ? WHITE_STONE : BLACK_STONE;
+    } else if ( state == GAME_STATE_FINISHED ) {
+        g->state = state;
+        g->winner = g->stone;
+    } else if ( g->state == GAME_STATE_PLAYING && board_is_full( g->board ) ) {
+        //A full board with no winner is a draw
+        g->state = GAME_STATE_FINISHED;
+        g->winner = EMPTY_INTERSECTION;
+        *draw = true;
     }
-    //Check if there's an empty intersection at the end
-    if ( on_board ) {
-        open_ended = board_get( g->board, x - 1, y ) == EMPTY_INTERSECTION;
-    }
-    return open_ended;
+    return true;
 }
 
-static bool count_east( const game* g, unsigned char x, unsigned char y, unsigned char* pos )
+unsigned char game_check_move( const game* g, unsigned char x, unsigned char y )
 {
-    
-    bool open_ended = false;
-    //Determine if traversing violates boundaries
-    bool on_board = in_bounds(g, x + 1, y );
-    if ( !on_board ) {
-        return open_ended;
-    }
-    //While the current stone matches the stone next to it, increment counter and increment coordinates
-    bool stone_match = g->stone == board_get( g->board, x + 1, y );
-    
-    while ( stone_match ) {
-        (*pos)++;
-        x++;
-        on_board = in_bounds(g, x + 1, y );
-        if ( on_board ) {
-            stone_match = g->stone == board_get( g->board, x + 1, y );
-        } else {
-            break;
-        }
-    }
-    //Check if there's an empty intersection at the end
-    if ( on_board ) {
-        open_ended = board_get( g->board, x + 1, y ) == EMPTY_INTERSECTION;
-    }
-    return open_ended;
+    //The kernels for the size and type of the game were picked by game_init
+    return g->kernels->check_move( g, x, y );
 }
 
-static bool count_northeast( const game* g, unsigned char x, unsigned char y, unsigned char* pos )
+unsigned char find_max_line( const game* g, const unsigned char x, const unsigned char y, unsigned char* open_fours ) 
 {
-    bool open_ended = false;
-    //Determine if traversing violates boundaries
-    bool on_board = in_bounds(g, x + 1, y + 1 );
-    if ( !on_board ) {
-        return open_ended;
-    }
-    //While the current stone matches the stone next to it, increment counter and increment coordinates
-    bool stone_match = g->stone == board_get( g->board, x + 1, y + 1 );
+    line_scan scans[NUM_AXES];
+    unsigned char max_line = 0;
     
-    while ( stone_match ) {
-        (*pos)++;
-        x++;
-        y++;
-        on_board = in_bounds(g, x + 1, y + 1 );
-        if ( on_board ) {
-            stone_match = g->stone == board_get( g->board, x + 1, y + 1 );
-        } else {
-            break;
+    game_scan_lines( g, x, y, scans );
+    for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+        //Compare each axis to max
+        if ( scans[axis].length >= max_line ) {
+            max_line = scans[axis].length;
         }
-    }
-    //Check if there's an empty intersection at the end
-    if ( on_board ) {
-        open_ended = board_get( g->board, x + 1, y + 1 ) == EMPTY_INTERSECTION;
-    }
-    return open_ended;
-}
-
-static bool count_southwest( const game* g, unsigned char x, unsigned char y, unsigned char* neg )
-{
-   bool open_ended = false;
-    //Determine if traversing violates boundaries
-    bool on_board = in_bounds(g, x - 1, y - 1 );
-    if ( !on_board ) {
-        return open_ended;
-    }
-    //While the current stone matches the stone next to it, increment counter and increment coordinates
-    bool stone_match = g->stone == board_get( g->board, x - 1, y - 1 );
-    
-    while ( stone_match ) {
-        (*neg)++;
-        x--;
-        y--;
-        on_board = in_bounds(g, x - 1, y - 1 );
-        if ( on_board ) {
-            stone_match = g->stone == board_get( g->board, x - 1, y - 1 );
-        } else {
-            break;
+        //Check for an open four and increment counter if so
+        if ( scans[axis].length == FOUR_IN_A_ROW && scans[axis].open_ends == 2 ) {
+            (*open_fours)++;
         }
     }
-    //Check if there's an empty intersection at the end
-    if ( on_board ) {
-        open_ended = board_get( g->board, x - 1, y - 1 ) == EMPTY_INTERSECTION;
-    }
-    return open_ended;
+    return max_line;
 }
 
-static bool count_northwest( const game* g, unsigned char x, unsigned char y, unsigned char* pos )
+void game_scan_lines( const game* g, unsigned char x, unsigned char y, line_scan* scans )
 {
-   bool open_ended = false;
-    //Determine if traversing violates boundaries
-    bool on_board = in_bounds(g, x - 1, y + 1 );
-    if ( !on_board ) {
-        return open_ended;
-    }
-    //While the current stone matches the stone next to it, increment counter and increment coordinates
-    bool stone_match = g->stone == board_get( g->board, x - 1, y + 1 );
-    
-    while ( stone_match ) {
-        (*pos)++;
-        x--;
-        y++;
-        on_board = in_bounds(g, x - 1, y + 1 );
-        if ( on_board ) {
-            stone_match = g->stone == board_get( g->board, x - 1, y + 1 );
-        } else {
-            break;
+    const board* b = g->board;
+    const unsigned char* grid = b->grid;
+    const int center = BOARD_INDEX( b, x, y );
+    
+    for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+        line_scan* scan = &scans[axis];
+        scan->length = 1;
+        scan->open_ends = 0;
+        scan->gap_pos = 0;
+        scan->gap_neg = 0;
+        
+        //Walk away from the center in the positive then the negative direction of the axis.
+        //The border sentinels never match a stone or an empty intersection, so no bounds check is needed
+        for ( int side = 0; side < 2; side++ ) {
+            const int delta = side == 0 ? b->step[axis] : -b->step[axis];
+            unsigned char* gap = side == 0 ? &scan->gap_pos : &scan->gap_neg;
+            int i = center + delta;
+            while ( grid[i] == g->stone ) {
+                scan->length++;
+                i += delta;
+            }
+            //Count the stones that continue the line after a single empty intersection
+            if ( grid[i] == EMPTY_INTERSECTION ) {
+                scan->open_ends++;
+                i += delta;
+                while ( grid[i] == g->stone ) {
+                    (*gap)++;
+                    i += delta;
+                }
+            }
         }
     }
-    //Check if there's an empty intersection at the end
-    if ( on_board ) {
-        open_ended = board_get( g->board, x - 1, y + 1 ) == EMPTY_INTERSECTION;
-    }
-    return open_ended;
 }
 
-static bool count_southeast( const game* g, unsigned char x, unsigned char y, unsigned char* neg )
+uint64_t game_hash( const game* g )
 {
-    bool open_ended = false;
-    //Determine if traversing violates boundaries
-    bool on_board = in_bounds(g, x + 1, y - 1 );
-    if ( !on_board ) {
-        return open_ended;
-    }
-    //While the current stone matches the stone next to it, increment counter and increment coordinates
-    bool stone_match = g->stone == board_get( g->board, x + 1, y - 1 );
-    
-    while ( stone_match ) {
-        (*neg)++;
-        x++;
-        y--;
-        on_board = in_bounds(g, x + 1, y - 1 );
-        if ( on_board ) {
-            stone_match = g->stone == board_get( g->board, x + 1, y - 1 );
-        } else {
-            break;
-        }
-    }
-    //Check if there's an empty intersection at the end
-    if ( on_board ) {
-        open_ended = board_get( g->board, x + 1, y - 1 ) == EMPTY_INTERSECTION;
+    if ( g->stone == WHITE_STONE ) {
+        return g->board->hash ^ board_zobrist_side();
     }
-    return open_ended;
+    return g->board->hash;
 }
 
-static bool in_bounds( const game* g, unsigned char x, unsigned char y ) 
+bool save_move( game* g, const unsigned char x, const unsigned char y) 
 {
-    if ( x < 0 || x >= g->board->size || y < 0 || y >= g->board->size ) {
+    if ( !has_room( g ) ) {
         return false;
-    } else {
-        return true;
     }
+    move mv = { x, y, g->stone };
+    g->moves[ g->moves_count++ ] = mv;
+    return true;
 }
 
-bool save_move( game* g, const unsigned char x, const unsigned char y) 
+static bool has_room( const game* g )
 {
-    //Double the moves list memory if at capacity
-    unsigned char num_moves = ( g->moves_count / sizeof( move ) );
-    
-    if ( num_moves == g->moves_capacity ) {
-        g->moves_capacity = g->moves_capacity * 2;
-        g->moves = ( move * )realloc( g->moves, g->moves_capacity * sizeof( move ) );
-    }
-    
-    move mv = { x, y, g->stone };
-    g->moves[num_moves] = mv;
-    g->moves_count += sizeof( move );
-    return true;
+    return g->moves_count < g->moves_capacity;
 }
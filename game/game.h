@@ -1,6 +1,7 @@
 #ifndef _GAME_H
 #define _GAME_H
 #include "board.h"
+#include "lines.h"
 #include <stdbool.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -12,8 +13,13 @@
 #define GAME_STATE_FINISHED 3
 #define FOUR_IN_A_ROW 4
 #define FIVE_IN_A_ROW 5
-#define MAX_OPEN_FOURS 1
-#define INITIAL_CAPACITY 16
+#define MAX_FOURS 1
+#define MAX_OPEN_THREES 1
+#ifdef _NOSLEEP
+#define REPLAY_DEFAULT_DELAY 0
+#else
+#define REPLAY_DEFAULT_DELAY 1000
+#endif
 
 typedef struct {
     unsigned char x;
@@ -21,31 +27,101 @@ typedef struct {
     unsigned char stone;
 } move;
 
+/**
+ * The result of scanning one axis through an intersection.
+ */
 typedef struct {
+    unsigned char length;    //Stones in the unbroken run through the intersection, including it
+    unsigned char open_ends; //Ends of the run followed by an empty intersection (0 to 2)
+    unsigned char gap_pos;   //Stones after the empty intersection past the positive end of the run
+    unsigned char gap_neg;   //Stones after the empty intersection past the negative end of the run
+} line_scan;
+
+/**
+ * The rule kernels compiled for the board size and type of a game, see rules.h.
+ */
+typedef struct rule_kernels rule_kernels;
+
+typedef struct game {
     board* board;
     unsigned char type;
     unsigned char stone;
     unsigned char state;
     unsigned char winner;
     move* moves;
-    size_t moves_count;
-    size_t moves_capacity;
+    size_t moves_count;    //Number of moves in the moves list
+    size_t moves_capacity; //Number of moves the moves list has room for
+    const rule_kernels* kernels; //Picked once by game_init
+    line_cache* lines;           //Classification of every line, only kept up to date while tracking_lines is set
+    bool tracking_lines;
 } game;
 
 /**
- * Creates and returns a dynamically allocated game of the specified type.
+ * Creates and returns a dynamically allocated game of the specified type. The game, its board, a moves
+ * list with room for a move on every intersection and the line cache are a single block, freed by game_delete.
  * @param board_size The desired size of the board.
  * @param game_type The desired game type (freestyle or renju).
  * @return The newly created and initialized game struct.
  */
 game* game_create(unsigned char board_size, unsigned char game_type);
 
+/**
+ * Creates a game like game_create, but reports errors instead of exiting.
+ * @param board_size The desired size of the board.
+ * @param game_type The desired game type (freestyle or renju).
+ * @param status Reference to the location where SUCCESS, BOARD_SIZE_ERR, INPUT_ERR or MEMORY_ERR is stored.
+ * @return The newly created and initialized game struct, or NULL on error.
+ */
+game* game_new(unsigned char board_size, unsigned char game_type, unsigned char* status);
+
+/**
+ * Returns the number of bytes a game with the given board size takes, board, moves list and line cache included.
+ * @param board_size The size of the board, assumed to be valid.
+ * @return The size of the memory block game_init needs.
+ */
+size_t game_footprint(unsigned char board_size);
+
+/**
+ * Lays out a new game in the given memory, which the caller owns, so that games can be pooled or packed
+ * into a larger arena. Such a game must not be passed to game_delete.
+ * @param memory At least game_footprint( board_size ) bytes, aligned like malloc memory.
+ * @param board_size The size of the board, assumed to be valid.
+ * @param game_type The game type, assumed to be valid.
+ * @return The game, at the start of the memory.
+ */
+game* game_init(void* memory, unsigned char board_size, unsigned char game_type);
+
+/**
+ * Empties the board and the moves list and gives black the first move, without freeing anything,
+ * so that the game can be reused for a new game of the same size and type.
+ * @param g The game to reset.
+ */
+void game_reset(game* g);
+
+/**
+ * Starts or stops keeping the line cache of a game up to date. Starting classifies every line of the board;
+ * from then on game_place_stone, game_make_move, game_unmake_move and game_reset update it, so that
+ * g->lines can be read at any time. Stones placed with board_set directly need another call to start.
+ * Off by default, since it makes every move a little slower.
+ * @param g The game.
+ * @param on True to keep the cache up to date, false to stop.
+ */
+void game_track_lines(game* g, bool on);
+
 /**
  * Frees the memory used for the given game struct.
  * @param g The game struct to free. Exits if this is NULL.
  */
 void game_delete(game* g);
 
+/**
+ * Creates an independent copy of the given game, with its own board and move list, so it can be
+ * searched or modified without touching the original.
+ * @param g The game to copy.
+ * @return The newly created game struct.
+ */
+game* game_copy(const game* g);
+
 /**
  * Reads the player's actions and updates the game accordingly.
  * Reprompts the player for input if the input is badly formatted.
@@ -69,17 +145,33 @@ void game_loop(game* g);
  */
 void game_resume(game* g);
 
+/**
+ * How a saved game is replayed. Move numbers start at 1.
+ * Moves before seek are played without printing. With final_only set only the last move is shown,
+ * otherwise with selected set only the listed move numbers are shown.
+ */
+typedef struct {
+    unsigned int delay_ms;          //Pause after each shown move
+    size_t seek;                    //First move to show, 0 or 1 for the start
+    bool final_only;
+    const size_t* selected;         //Move numbers to show, or NULL for every move
+    size_t num_selected;
+    bool diff;                      //Repaint only the intersections that changed, see board_print
+} replay_options;
+
 /** 
- * Replays a saved game.
+ * Replays a saved game, printing the board and the moves so far after each shown move.
  * @param g The game to replay
+ * @param options Which moves to show and how long to pause after each.
  */
-void game_replay(game* g);
+void game_replay(game* g, const replay_options* options);
 
 /**
  * Prints all moves recorded from the game along with the player that made them.
  * @param g The game with recorded moves to print.
+ * @return The number of lines printed, the last one left open after a black move included.
  */
-void print_moves( game* g );
+unsigned int print_moves( game* g );
 
 /**
  * Receives information on the desired move and checks if the move can be made 
@@ -92,14 +184,73 @@ void print_moves( game* g );
  */
 bool game_place_stone(game* g, unsigned char x, unsigned char y);
 
+/**
+ * Makes a move for the current player without printing anything: places the stone, saves the move,
+ * updates the game state and winner, and switches players. Board caches such as the bitboards,
+ * the empty set and the hash are updated by board_set.
+ * @param g The game in which the move should be made. Must be in the GAME_STATE_PLAYING state.
+ * @param x The horizontal coordinate of the move.
+ * @param y The vertical coordinate of the move.
+ * @return True if the move was made, false if the game is over, the intersection is off the board or occupied, or the moves list is full.
+ */
+bool game_make_move( game* g, unsigned char x, unsigned char y );
+
+/**
+ * Takes back the last saved move: removes its stone, drops it from the moves list, gives the turn back to
+ * its player and puts the game back in the GAME_STATE_PLAYING state. Never prints anything.
+ * @param g The game in which the move should be undone.
+ * @return True if a move was undone, false if there are no moves to undo.
+ */
+bool game_unmake_move( game* g );
+
+/**
+ * Determines how placing a stone of the current color at the given intersection would end the game,
+ * without placing it. In renju, black wins only with an exact five, and any other move that makes an
+ * overline, two fours or two open threes is forbidden. White, and both players in freestyle, win with
+ * five or more in a row.
+ * @param g The game to check.
+ * @param x The horizontal coordinate of the move.
+ * @param y The vertical coordinate of the move.
+ * @return GAME_STATE_FINISHED if the move wins, GAME_STATE_FORBIDDEN if it is forbidden, GAME_STATE_PLAYING otherwise.
+ */
+unsigned char game_check_move( const game* g, unsigned char x, unsigned char y );
+
+/**
+ * Returns the Zobrist key of the current position: the board hash maintained by board_set,
+ * combined with the side to move.
+ * @param g The game to hash.
+ * @return The 64-bit position key.
+ */
+uint64_t game_hash( const game* g );
+
 /**
  * Saves the move with the current active stone and the given coordinates to the moves list.
- * Grows the moves list by doubling if necessary.
  * @param g The game to check.
  * @param x The horizontal coordinate of the last stone placed.
  * @param y The vertical coordinate of the last stone placed.
- * @return True if the move was successfully saved, false if not.
+ * @return True if the move was successfully saved, false if the moves list is full.
  */
 bool save_move( game* g, const unsigned char x, const unsigned char y);
 
+/**
+ * Checks if the area on the given board surrounding a given coordinate and finds the longest continuous 
+ * line of stones of the current color it connects to. Also determines the number of open fours surrounding the given location.
+ * @param g The game to check.
+ * @param x The horizontal coordinate of the last stone placed.
+ * @param y The vertical coordinate of the last stone placed.
+ * @param open_fours A counter that is incremented each time an open four is found at the given coordinates.
+ * @return The length of the longest line through the intersection.
+ */
+unsigned char find_max_line( const game* g, const unsigned char x, const unsigned char y, unsigned char* open_fours );
+
+/**
+ * Scans all four axes through the given intersection for stones of the current color in a single pass.
+ * The intersection itself counts as one stone of the current color.
+ * @param g The game to check.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param scans Array of NUM_AXES results, indexed by AXIS_HORIZONTAL, AXIS_VERTICAL, AXIS_DIAGONAL and AXIS_ANTIDIAGONAL.
+ */
+void game_scan_lines( const game* g, unsigned char x, unsigned char y, line_scan* scans );
+
 #endif
@@ -1,6 +1,8 @@
 #include "game.h"
 #include "board.h"
 #include "io.h"
+#include "engine.h"
+#include "protocol.h"
 #include "error-codes.h"
 #include <string.h>
 
@@ -11,9 +13,15 @@ static void arg_error();
 
 /**
  * Initiates a game of Gomoku (freestyle).
- * Use -b in arguments followed by board size to create a board 15x15 17x17 or 19x19.
+ * Use -b in arguments followed by board size to create a board from 15x15 up to 64x64.
  * Use -r followed by a file name to resume a given game.
  * Use -o followed by a file name to save the game after it is stopped or finished.
+ * Use -ai followed by black or white to let the computer play that color.
+ * Use -hash followed by a number of megabytes to size the computer's transposition table.
+ * Use -threads followed by a number of threads to let the computer search with that many threads.
+ * Use -book followed by an opening book built by openbook to let the computer play its moves in known openings.
+ * Use -draw followed by diff to repaint only the intersections that changed each turn (full by default).
+ * Use -protocol followed by piskvork to be driven by a tournament manager on standard input and output instead.
  * @param argc The total number of arguments.
  * @param argv[] Array of arguments.
  * return 0 if successful.
@@ -22,16 +30,58 @@ int main( int argc, char *argv[] ) {
     bool custom_board = false;
     bool resume = false;
     bool save = false;
+    unsigned char ai_stone = EMPTY_INTERSECTION;
+    engine_limits limits = { 0, ENGINE_DEFAULT_TIME, NULL, 1 };
+    int hash_mb = TT_DEFAULT_MB;
+    bool diff = false;
+    bool protocol = false;
     unsigned char board_size = 15;
     char* path;
     game* g = game_create( board_size, GAME_FREESTYLE );
     
-    if ( argc > 5 || argc % 2 == 0 ) { //Too many arguments supplied OR even number of arguments supplied
+    if ( argc > 17 || argc % 2 == 0 ) { //Too many arguments supplied OR even number of arguments supplied
         arg_error();
     } else {
         for ( int i = 1; i < argc; i += 2 ) { //Iterate through every other arg expecting a -b -o or -r          
             if ( (unsigned char) argv[i][0] != '-' || (unsigned char) argv[i + 1][0] == '-' ) {
                 arg_error();
+            } else if ( strcmp( argv[i], "-ai" ) == 0 ) { //AI OPTION FOUND
+                if ( strcmp( argv[i + 1], "black" ) == 0 ) {
+                    ai_stone = BLACK_STONE;
+                } else if ( strcmp( argv[i + 1], "white" ) == 0 ) {
+                    ai_stone = WHITE_STONE;
+                } else {
+                    arg_error();
+                }
+            } else if ( strcmp( argv[i], "-hash" ) == 0 ) { //HASH SIZE OPTION FOUND
+                hash_mb = atoi( argv[i + 1] );
+                if ( hash_mb <= 0 ) {
+                    arg_error();
+                }
+            } else if ( strcmp( argv[i], "-threads" ) == 0 ) { //THREAD COUNT OPTION FOUND
+                int threads = atoi( argv[i + 1] );
+                if ( threads <= 0 || threads > ENGINE_MAX_THREADS ) {
+                    arg_error();
+                }
+                limits.threads = threads;
+            } else if ( strcmp( argv[i], "-book" ) == 0 ) { //OPENING BOOK OPTION FOUND
+                if ( limits.book != NULL ) {
+                    arg_error();
+                }
+                limits.book = book_open( argv[i + 1] );
+            } else if ( strcmp( argv[i], "-protocol" ) == 0 ) { //PROTOCOL OPTION FOUND
+                if ( strcmp( argv[i + 1], "piskvork" ) != 0 ) {
+                    arg_error();
+                }
+                protocol = true;
+            } else if ( strcmp( argv[i], "-draw" ) == 0 ) { //DRAW MODE OPTION FOUND
+                if ( strcmp( argv[i + 1], "diff" ) == 0 ) {
+                    diff = true;
+                } else if ( strcmp( argv[i + 1], "full" ) == 0 ) {
+                    diff = false;
+                } else {
+                    arg_error();
+                }
             } else if ( argv[i][1] == 'b' ) { //BOARD ARGUMENT FOUND
                 if ( strlen( argv[i + 1] ) > 2 || resume ) {
                     arg_error();
@@ -55,8 +105,23 @@ int main( int argc, char *argv[] ) {
             }
         }
         
-        if ( resume ) {
+        g->board->diff = diff;
+        if ( ai_stone != EMPTY_INTERSECTION || protocol ) {
+            limits.table = tt_create( hash_mb );
+        }
+        
+        if ( protocol ) {
+            protocol_loop( g->type, &limits );
+        } else if ( resume && ai_stone == EMPTY_INTERSECTION ) {
             game_resume( g );
+        } else if ( resume ) {
+            if ( g->state != GAME_STATE_STOPPED ) {
+                exit( RESUME_ERR );
+            }
+            g->state = GAME_STATE_PLAYING;
+            engine_loop( g, ai_stone, &limits );
+        } else if ( g->state == GAME_STATE_PLAYING && ai_stone != EMPTY_INTERSECTION ) {
+            engine_loop( g, ai_stone, &limits );
         } else if ( g->state == GAME_STATE_PLAYING ) {
             game_loop(g);
         }
@@ -67,11 +132,17 @@ int main( int argc, char *argv[] ) {
         
         //Free game memory
         game_delete( g );
+        if ( limits.table != NULL ) {
+            tt_delete( limits.table );
+        }
+        if ( limits.book != NULL ) {
+            book_close( ( book * )limits.book );
+        }
     }
     return 0;
 }
 
 static void arg_error() {
-    printf( "usage: ./gomoku [-r <unfinished-match.gmk>] [-o <saved-match.gmk>] [-b <15|17|19>]\n       -r and -b conflicts with each other\n" );
+    printf( "usage: ./gomoku [-r <unfinished-match.gmk>] [-o <saved-match.gmk>] [-b <15-64>] [-ai <black|white>] [-hash <megabytes>] [-threads <count>] [-book <book.gmo>] [-draw <full|diff>] [-protocol piskvork]\n       -r and -b conflicts with each other\n" );
     exit( ARGUMENT_ERR );
 }
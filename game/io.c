@@ -6,67 +6,84 @@
 
 
 game* game_import(const char* path) 
+{
+    unsigned char status;
+    game* g = game_load( path, &status );
+    if ( g == NULL && status == MEMORY_ERR ) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    } else if ( g == NULL ) {
+        exit( status );
+    }
+    return g;
+}
+
+game* game_load(const char* path, unsigned char* status) 
 {
     FILE *file = fopen( path, "r" );
     
     if ( file == NULL ) {
-        exit ( FILE_INPUT_ERR );
+        *status = FILE_INPUT_ERR;
+        return NULL;
     }
     
     //First line should be GA
     int G = fgetc( file );
     int A = fgetc( file );
     if ( G != 'G' || A != 'A' ) {
-        exit( FILE_INPUT_ERR );
+        fclose( file );
+        *status = FILE_INPUT_ERR;
+        return NULL;
     }
     
-    //Line 2: Board size
+    //Lines 2 to 5: Board size, game type, game state and winner
     unsigned char board_size;
-    fscanf( file, " %hhu", &board_size );
-    
-    //Line 3: Game type
     unsigned char type;
-    fscanf( file, " %hhu", &type );
-    //Create game from above information
-    game* g = game_create( board_size, type );
-    
-    //Line 4: game state
     unsigned char state;
-    fscanf( file, " %hhu", &state );
-    //Bounds check state
-    if ( state < GAME_STATE_FORBIDDEN || state > GAME_STATE_FINISHED ) {
-            exit( FILE_INPUT_ERR );
-    }
-    g->state = state;
-    
-    //Line 5: Winner
     unsigned char winner;
-    fscanf( file, " %hhu", &winner );
-    //Bounds check winner
-    if ( winner < EMPTY_INTERSECTION || winner > WHITE_STONE ) {
-        exit( FILE_INPUT_ERR );
+    if ( fscanf( file, " %hhu %hhu %hhu %hhu", &board_size, &type, &state, &winner ) != 4 ) {
+        fclose( file );
+        *status = FILE_INPUT_ERR;
+        return NULL;
+    }
+    //Bounds check everything before creating the game
+    *status = SUCCESS;
+    if ( !board_size_valid( board_size ) ) {
+        *status = BOARD_SIZE_ERR;
+    } else if ( type != GAME_FREESTYLE && type != GAME_RENJU ) {
+        *status = INPUT_ERR;
+    } else if ( state < GAME_STATE_FORBIDDEN || state > GAME_STATE_FINISHED ) {
+        *status = FILE_INPUT_ERR;
+    } else if ( winner < EMPTY_INTERSECTION || winner > WHITE_STONE ) {
+        *status = FILE_INPUT_ERR;
+    }
+    if ( *status != SUCCESS ) {
+        fclose( file );
+        return NULL;
+    }
+    //Create game from above information
+    game* g = game_new( board_size, type, status );
+    if ( g == NULL ) {
+        fclose( file );
+        return NULL;
     }
+    g->state = state;
     g->winner = winner;
     
-    //Go through remaining lines and place stones accordingly
+    //Go through remaining lines and place stones accordingly, stopping at the first line that is not a coordinate
     unsigned char x = 0;
     unsigned char y = 0;
-    char* formal_coord = (char*)malloc( 3 * sizeof( char ) );
-    int scanner = fscanf( file, " %s", formal_coord );
-    unsigned char convert_success = SUCCESS;
-    //bool stone_placed = true;
-    while ( convert_success == SUCCESS ) {
-        convert_success = board_coord( g->board, formal_coord, &x, &y );
-        
-       // if ( g->state != GAME_STATE_PLAYING && g ->state != GAME_STATE_STOPPED ) {
-       //     break;
-       // }
-        
+    char formal_coord[16];
+    while ( fscanf( file, " %15s", formal_coord ) == 1 && board_coord( g->board, formal_coord, &x, &y ) == SUCCESS ) {
         //Place stone and save
-        if ( convert_success == SUCCESS ) {
-            board_set( g->board, x, y, g->stone );
-            save_move( g, x, y );
-        } 
+        board_set( g->board, x, y, g->stone );
+        if ( !save_move( g, x, y ) ) {
+            //More moves than intersections
+            fclose( file );
+            game_delete( g );
+            *status = FILE_INPUT_ERR;
+            return NULL;
+        }
         
         //Switch players
         if ( g->stone == BLACK_STONE ) {
@@ -74,13 +91,6 @@ game* game_import(const char* path)
         } else {
             g->stone = BLACK_STONE;
         }
-
-        scanner = fscanf( file, " %s", formal_coord );
-        
-        //Check for EOF
-        if ( scanner == EOF ) {
-            break;
-        }
     }
     
     fclose( file );
@@ -89,54 +99,38 @@ game* game_import(const char* path)
 
 void game_export(game* g, const char* path) 
 {
-    FILE *file = fopen( path, "w" );
-    
-    //First line should be GA
-    fputc( 'G', file );
-    fputc( 'A', file );
-    fputc( '\n', file );
-    
-    //Line 2: Board size
-    fprintf( file, "%hhu", g->board->size );
-    fputc( '\n', file );
-    
-    //Line 3: Game type
-    fprintf( file, "%hhu", g->type );
-    fputc( '\n', file );
+    unsigned char status = game_save( g, path );
+    if ( status != SUCCESS ) {
+        exit( status );
+    }
+}
 
-    //Line 4: game state
-    fprintf( file, "%hhu", g->state );
-    fputc( '\n', file );
+unsigned char game_save(const game* g, const char* path) 
+{
+    FILE *file = fopen( path, "w" );
+    if ( file == NULL ) {
+        return FILE_OUTPUT_ERR;
+    }
     
-    //Line 5: Winner
-    fprintf( file, "%hhu", g->winner );
-    fputc( '\n', file );
+    //Lines 1 to 5: GA, board size, game type, game state and winner. The format has no playing state,
+    //so a game in progress is saved as stopped
+    unsigned char state = g->state == GAME_STATE_PLAYING ? GAME_STATE_STOPPED : g->state;
+    fprintf( file, "GA\n%hhu\n%hhu\n%hhu\n%hhu\n", g->board->size, g->type, state, g->winner );
     
     //Go through remaining lines and place stones accordingly
-    unsigned char num_moves = ( g->moves_count / sizeof( move ) );
-    char* formal_coord = (char*)malloc( 4 * sizeof( char ) );
-    formal_coord[3] = '\0'; //set null terminator
-    unsigned char x;
-    unsigned char y;
-    unsigned char convert_success;
-    unsigned char write_success;
-    for ( int i = 0; i < num_moves; i++ ) {
-        x = g->moves[i].x;
-        y = g->moves[i].y;
-        convert_success = board_formal_coord( g->board, x, y, formal_coord );
-        
-        if ( convert_success != SUCCESS ) {
-            exit ( FORMAL_COORDINATE_ERR );
-        }
-        
-        write_success = fprintf( file, "%s\n", formal_coord );
-        
-        if ( write_success < 0 ) {
-            exit ( FILE_OUTPUT_ERR );
+    char formal_coord[BOARD_COORD_LENGTH];
+    for ( size_t i = 0; i < g->moves_count; i++ ) {
+        if ( board_formal_coord( g->board, g->moves[i].x, g->moves[i].y, formal_coord ) != SUCCESS ) {
+            fclose( file );
+            return FORMAL_COORDINATE_ERR;
         }
+        fprintf( file, "%s\n", formal_coord );
     }
     
-    free( formal_coord );
-    fclose( file );
+    //Write errors stick to the stream, so checking once at the end is enough
+    bool failed = ferror( file );
+    if ( fclose( file ) != 0 || failed ) {
+        return FILE_OUTPUT_ERR;
+    }
+    return SUCCESS;
 }
-    
\ No newline at end of file
@@ -9,6 +9,27 @@
  */
 game* game_import(const char* path);
 
+/**
+ * Loads a saved game from the designated path like game_import, but reports errors instead of exiting.
+ * @param path Path to the file to load.
+ * @param status Reference to the location where SUCCESS or the error code is stored.
+ * @return A newly created game object from the designated file, or NULL if it could not be loaded.
+ */
+game* game_load(const char* path, unsigned char* status);
 
+/**
+ * Saves a game to the designated path in the text .gmk format. Exits with error if the file cannot be written.
+ * A game still in the GAME_STATE_PLAYING state is saved as stopped.
+ * @param g The game to save.
+ * @param path Path to the file to write.
+ */
 void game_export(game* g, const char* path);
+
+/**
+ * Saves a game like game_export, but reports errors instead of exiting.
+ * @param g The game to save.
+ * @param path Path to the file to write.
+ * @return SUCCESS, FILE_OUTPUT_ERR or FORMAL_COORDINATE_ERR.
+ */
+unsigned char game_save(const game* g, const char* path);
 #endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "libgomoku.h"
+#include "game.h"
+#include "board.h"
+#include "io.h"
+#include "error-codes.h"
+
+/**
+ * The public handle wraps the internal game, so the game struct can change without breaking the API.
+ */
+struct gmk_game {
+    game* g;
+};
+
+/**
+ * Checks that coordinates are on the board of a game.
+ * @param g The game.
+ * @param x The column.
+ * @param y The row.
+ * @return True if the intersection exists.
+ */
+static bool on_board( const gmk_game* g, int x, int y );
+
+/**
+ * Wraps an internal game in a new handle, freeing the game if the handle cannot be allocated.
+ * @param g The game to wrap.
+ * @param out Reference to the location where the handle is stored.
+ * @return GMK_OK or GMK_ERR_MEMORY.
+ */
+static int wrap( game* g, gmk_game** out );
+
+int gmk_version( void )
+{
+    return GMK_API_VERSION;
+}
+
+int gmk_init( void )
+{
+    //Creating a game builds the pattern and Zobrist tables
+    unsigned char status;
+    game* g = game_new( 15, GAME_FREESTYLE, &status );
+    if ( g == NULL ) {
+        return status;
+    }
+    game_delete( g );
+    return GMK_OK;
+}
+
+int gmk_create( int size, int type, gmk_game** out )
+{
+    if ( out == NULL ) {
+        return GMK_ERR_NULL;
+    }
+    *out = NULL;
+    if ( size < 0 || size > BOARD_MAX_SIZE ) {
+        return GMK_ERR_BOARD_SIZE;
+    } else if ( type != GMK_FREESTYLE && type != GMK_RENJU ) {
+        return GMK_ERR_INPUT;
+    }
+    unsigned char status;
+    game* g = game_new( size, type, &status );
+    if ( g == NULL ) {
+        return status;
+    }
+    return wrap( g, out );
+}
+
+void gmk_delete( gmk_game* g )
+{
+    if ( g != NULL ) {
+        game_delete( g->g );
+        free( g );
+    }
+}
+
+int gmk_load( const char* path, gmk_game** out )
+{
+    if ( path == NULL || out == NULL ) {
+        return GMK_ERR_NULL;
+    }
+    *out = NULL;
+    unsigned char status;
+    game* g = game_load( path, &status );
+    if ( g == NULL ) {
+        return status;
+    }
+    //A stopped game is resumed, like the -r option of the command line programs
+    if ( g->state == GAME_STATE_STOPPED ) {
+        g->state = GAME_STATE_PLAYING;
+    }
+    return wrap( g, out );
+}
+
+int gmk_save( const gmk_game* g, const char* path )
+{
+    if ( g == NULL || path == NULL ) {
+        return GMK_ERR_NULL;
+    }
+    //game_save writes a game in progress as stopped, the only unfinished state of the file format
+    unsigned char status = game_save( g->g, path );
+    return status == SUCCESS ? GMK_OK : GMK_ERR_FILE_OUTPUT;
+}
+
+int gmk_play( gmk_game* g, int x, int y )
+{
+    if ( g == NULL ) {
+        return GMK_ERR_NULL;
+    } else if ( !on_board( g, x, y ) ) {
+        return GMK_ERR_COORDINATE;
+    } else if ( g->g->state != GAME_STATE_PLAYING ) {
+        return GMK_ERR_GAME_OVER;
+    } else if ( board_get( g->g->board, x, y ) != EMPTY_INTERSECTION ) {
+        return GMK_ERR_OCCUPIED;
+    } else if ( !game_make_move( g->g, x, y ) ) {
+        //Only a loaded game that placed several stones on the same intersection can run out of room for moves
+        return GMK_ERR_INPUT;
+    }
+    return GMK_OK;
+}
+
+int gmk_reset( gmk_game* g )
+{
+    if ( g == NULL ) {
+        return GMK_ERR_NULL;
+    }
+    game_reset( g->g );
+    return GMK_OK;
+}
+
+int gmk_undo( gmk_game* g )
+{
+    if ( g == NULL ) {
+        return GMK_ERR_NULL;
+    } else if ( !game_unmake_move( g->g ) ) {
+        return GMK_ERR_NO_MOVES;
+    }
+    return GMK_OK;
+}
+
+int gmk_check( const gmk_game* g, int x, int y, int* state )
+{
+    if ( g == NULL || state == NULL ) {
+        return GMK_ERR_NULL;
+    } else if ( !on_board( g, x, y ) ) {
+        return GMK_ERR_COORDINATE;
+    } else if ( board_get( g->g->board, x, y ) != EMPTY_INTERSECTION ) {
+        return GMK_ERR_OCCUPIED;
+    }
+    *state = game_check_move( g->g, x, y );
+    return GMK_OK;
+}
+
+int gmk_stone_at( const gmk_game* g, int x, int y, int* stone )
+{
+    if ( g == NULL || stone == NULL ) {
+        return GMK_ERR_NULL;
+    } else if ( !on_board( g, x, y ) ) {
+        return GMK_ERR_COORDINATE;
+    }
+    *stone = board_get( g->g->board, x, y );
+    return GMK_OK;
+}
+
+int gmk_move_at( const gmk_game* g, size_t index, int* x, int* y, int* stone )
+{
+    if ( g == NULL || x == NULL || y == NULL ) {
+        return GMK_ERR_NULL;
+    } else if ( index >= gmk_move_count( g ) ) {
+        return GMK_ERR_INPUT;
+    }
+    *x = g->g->moves[index].x;
+    *y = g->g->moves[index].y;
+    if ( stone != NULL ) {
+        *stone = g->g->moves[index].stone;
+    }
+    return GMK_OK;
+}
+
+int gmk_size( const gmk_game* g )
+{
+    return g == NULL ? 0 : g->g->board->size;
+}
+
+int gmk_type( const gmk_game* g )
+{
+    return g == NULL ? 0 : g->g->type;
+}
+
+int gmk_state( const gmk_game* g )
+{
+    return g == NULL ? 0 : g->g->state;
+}
+
+int gmk_winner( const gmk_game* g )
+{
+    return g == NULL ? 0 : g->g->winner;
+}
+
+int gmk_to_move( const gmk_game* g )
+{
+    return g == NULL ? 0 : g->g->stone;
+}
+
+size_t gmk_move_count( const gmk_game* g )
+{
+    return g == NULL ? 0 : g->g->moves_count;
+}
+
+uint64_t gmk_hash( const gmk_game* g )
+{
+    return g == NULL ? 0 : game_hash( g->g );
+}
+
+static bool on_board( const gmk_game* g, int x, int y )
+{
+    return x >= 0 && x < g->g->board->size && y >= 0 && y < g->g->board->size;
+}
+
+static int wrap( game* g, gmk_game** out )
+{
+    gmk_game* handle = ( gmk_game * )malloc( sizeof( gmk_game ) );
+    if ( handle == NULL ) {
+        game_delete( g );
+        return GMK_ERR_MEMORY;
+    }
+    handle->g = g;
+    *out = handle;
+    return GMK_OK;
+}
@@ -0,0 +1,156 @@
+#ifndef _LIBGOMOKU_H_
+#define _LIBGOMOKU_H_
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#ifdef __GNUC__
+#define GMK_API __attribute__((visibility("default")))
+#else
+#define GMK_API
+#endif
+#define GMK_API_VERSION 1
+
+//Error codes, the same numbers the command line programs exit with
+#define GMK_OK 0
+#define GMK_ERR_BOARD_SIZE 1
+#define GMK_ERR_COORDINATE 3
+#define GMK_ERR_NULL 5
+#define GMK_ERR_INPUT 6
+#define GMK_ERR_FILE_OUTPUT 7
+#define GMK_ERR_FILE_INPUT 8
+#define GMK_ERR_MEMORY 11
+#define GMK_ERR_OCCUPIED 12
+#define GMK_ERR_GAME_OVER 13
+#define GMK_ERR_NO_MOVES 14
+
+#define GMK_FREESTYLE 0
+#define GMK_RENJU 1
+#define GMK_EMPTY 0
+#define GMK_BLACK 1
+#define GMK_WHITE 2
+#define GMK_PLAYING 0
+#define GMK_FORBIDDEN 1
+#define GMK_STOPPED 2
+#define GMK_FINISHED 3
+
+/**
+ * A game of gomoku or renju. The layout is private to the library, so programs built against this header
+ * keep working with later versions of libgomoku.a and libgomoku.so.
+ * A game may be used by one thread at a time; different games may be used by different threads at once.
+ * No function of the library prints anything or exits the process.
+ */
+typedef struct gmk_game gmk_game;
+
+/**
+ * Returns the version of the API the library implements, to compare with GMK_API_VERSION.
+ * @return The API version.
+ */
+GMK_API int gmk_version(void);
+
+/**
+ * Builds the tables shared by all games. Must be called once before games are created from several threads;
+ * otherwise the first gmk_create does it.
+ * @return GMK_OK or GMK_ERR_MEMORY.
+ */
+GMK_API int gmk_init(void);
+
+/**
+ * Creates an empty game, with a single allocation.
+ * @param size The length of one side of the board, from 15 to 64.
+ * @param type GMK_FREESTYLE or GMK_RENJU.
+ * @param out Reference to the location where the new game is stored, or NULL on error.
+ * @return GMK_OK, GMK_ERR_NULL, GMK_ERR_BOARD_SIZE, GMK_ERR_INPUT or GMK_ERR_MEMORY.
+ */
+GMK_API int gmk_create(int size, int type, gmk_game** out);
+
+/**
+ * Frees a game. Does nothing when given NULL.
+ * @param g The game to free.
+ */
+GMK_API void gmk_delete(gmk_game* g);
+
+/**
+ * Loads a game saved in the text .gmk format. A stopped game is put back in play.
+ * @param path Path to the file to load.
+ * @param out Reference to the location where the new game is stored, or NULL on error.
+ * @return GMK_OK, GMK_ERR_NULL, GMK_ERR_FILE_INPUT, GMK_ERR_BOARD_SIZE, GMK_ERR_INPUT or GMK_ERR_MEMORY.
+ */
+GMK_API int gmk_load(const char* path, gmk_game** out);
+
+/**
+ * Saves a game in the text .gmk format. A game in progress is saved as stopped, like the command line programs do.
+ * @param g The game to save.
+ * @param path Path to the file to write.
+ * @return GMK_OK, GMK_ERR_NULL or GMK_ERR_FILE_OUTPUT.
+ */
+GMK_API int gmk_save(const gmk_game* g, const char* path);
+
+/**
+ * Plays a stone of the side to move, updating the state and winner and passing the turn.
+ * A forbidden renju move is played and loses, like in the command line programs; use gmk_check first to avoid it.
+ * @param g The game.
+ * @param x The column, from 0.
+ * @param y The row, from 0.
+ * @return GMK_OK, GMK_ERR_NULL, GMK_ERR_COORDINATE, GMK_ERR_OCCUPIED, GMK_ERR_GAME_OVER or GMK_ERR_INPUT.
+ */
+GMK_API int gmk_play(gmk_game* g, int x, int y);
+
+/**
+ * Empties the board for a new game of the same size and type without allocating, to reuse a game.
+ * @param g The game.
+ * @return GMK_OK or GMK_ERR_NULL.
+ */
+GMK_API int gmk_reset(gmk_game* g);
+
+/**
+ * Takes back the last move and puts the game back in play.
+ * @param g The game.
+ * @return GMK_OK, GMK_ERR_NULL or GMK_ERR_NO_MOVES.
+ */
+GMK_API int gmk_undo(gmk_game* g);
+
+/**
+ * Tells how a stone of the side to move would end the game, without playing it.
+ * @param g The game.
+ * @param x The column, from 0.
+ * @param y The row, from 0.
+ * @param state Reference to the location where GMK_FINISHED, GMK_FORBIDDEN or GMK_PLAYING is stored.
+ * @return GMK_OK, GMK_ERR_NULL, GMK_ERR_COORDINATE or GMK_ERR_OCCUPIED.
+ */
+GMK_API int gmk_check(const gmk_game* g, int x, int y, int* state);
+
+/**
+ * Reads the stone at an intersection.
+ * @param g The game.
+ * @param x The column, from 0.
+ * @param y The row, from 0.
+ * @param stone Reference to the location where GMK_EMPTY, GMK_BLACK or GMK_WHITE is stored.
+ * @return GMK_OK, GMK_ERR_NULL or GMK_ERR_COORDINATE.
+ */
+GMK_API int gmk_stone_at(const gmk_game* g, int x, int y, int* stone);
+
+/**
+ * Reads a move of the game.
+ * @param g The game.
+ * @param index The number of the move, from 0.
+ * @param x Reference to the location where the column is stored.
+ * @param y Reference to the location where the row is stored.
+ * @param stone Reference to the location where the color is stored, or NULL.
+ * @return GMK_OK, GMK_ERR_NULL or GMK_ERR_INPUT if there is no such move.
+ */
+GMK_API int gmk_move_at(const gmk_game* g, size_t index, int* x, int* y, int* stone);
+
+/**
+ * Getters of a game. Given NULL, they return 0.
+ * @param g The game.
+ * @return The board size, the game type, the state, the winner (GMK_EMPTY while playing or for a draw),
+ * the color to move, the number of moves, or the Zobrist key of the position.
+ */
+GMK_API int gmk_size(const gmk_game* g);
+GMK_API int gmk_type(const gmk_game* g);
+GMK_API int gmk_state(const gmk_game* g);
+GMK_API int gmk_winner(const gmk_game* g);
+GMK_API int gmk_to_move(const gmk_game* g);
+GMK_API size_t gmk_move_count(const gmk_game* g);
+GMK_API uint64_t gmk_hash(const gmk_game* g);
+#endif
@@ -0,0 +1,178 @@
+#include "lines.h"
+#include <string.h>
+
+/**
+ * Moves of one intersection along each axis, in coordinates.
+ */
+static const int axis_dx[NUM_AXES] = { 1, 0, 1, 1 };
+static const int axis_dy[NUM_AXES] = { 0, 1, 1, -1 };
+
+/**
+ * Place value in a key of the intersection at each distance before (negative) or after the center, from
+ * -PATTERN_REACH to PATTERN_REACH, like pattern_key. The center itself is not part of the key.
+ */
+static const unsigned short place_values[2 * PATTERN_REACH + 1] = { 1, 3, 9, 27, 81, 0, 243, 729, 2187, 6561, 19683 };
+
+/**
+ * The bits of a window of PATTERN_REACH intersections on either side of its center, center included, in a line bitboard.
+ */
+#define WINDOW_BITS ( ( ( line_bits ) 1 << ( 2 * PATTERN_REACH + 1 ) ) - 1 )
+
+/**
+ * Returns the counters a pattern of a color at an intersection adds to, which depend on what it holds.
+ * @param cache The cache.
+ * @param content What the intersection holds.
+ * @param stone The color of the pattern.
+ * @return The moves or stones counters of the color, or NULL if the intersection holds the other color.
+ */
+static unsigned int* counters( line_cache* cache, unsigned char content, unsigned char stone );
+
+/**
+ * Returns the index of the keys and patterns of an intersection along the four axes for one color.
+ * @param cache The cache.
+ * @param cell The BOARD_CELL number of the intersection.
+ * @param stone The color of the keys.
+ * @return The index of the key and pattern of the first axis.
+ */
+static int slot( const line_cache* cache, int cell, unsigned char stone );
+
+size_t lines_footprint( unsigned char size )
+{
+    return BOARD_ALIGN_UP( sizeof( line_cache ) ) + BOARD_ALIGN_UP( 2 * size * size * NUM_AXES * sizeof( unsigned short ) ) +
+           BOARD_ALIGN_UP( 2 * size * size * NUM_AXES * sizeof( unsigned char ) );
+}
+
+line_cache* lines_init( void* memory, unsigned char size, bool exact )
+{
+    line_cache* cache = ( line_cache * )memory;
+    cache->size = size;
+    cache->exact = exact;
+    cache->keys = ( unsigned short * )( ( char * )memory + BOARD_ALIGN_UP( sizeof( line_cache ) ) );
+    cache->patterns = ( unsigned char * )cache->keys + BOARD_ALIGN_UP( 2 * size * size * NUM_AXES * sizeof( unsigned short ) );
+    return cache;
+}
+
+void lines_rebuild( line_cache* cache, const board* b )
+{
+    memset( cache->moves, 0, sizeof( cache->moves ) );
+    memset( cache->stones, 0, sizeof( cache->stones ) );
+    for ( unsigned char y = 0; y < b->size; y++ ) {
+        for ( unsigned char x = 0; x < b->size; x++ ) {
+            unsigned char content = b->grid[ BOARD_INDEX( b, x, y ) ];
+            for ( unsigned char stone = BLACK_STONE; stone <= WHITE_STONE; stone++ ) {
+                const bool exact = cache->exact && stone == BLACK_STONE;
+                const int first = slot( cache, BOARD_CELL( b, x, y ), stone );
+                unsigned int* count = counters( cache, content, stone );
+                for ( unsigned char axis = 0; axis < NUM_AXES; axis++ ) {
+                    cache->keys[ first + axis ] = pattern_key( b, x, y, stone, axis );
+                    cache->patterns[ first + axis ] = pattern_of( cache->keys[ first + axis ], exact );
+                    if ( count != NULL ) {
+                        count[ cache->patterns[ first + axis ] ]++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void lines_update( line_cache* cache, const board* b, unsigned char x, unsigned char y, unsigned char previous )
+{
+    const unsigned char content = b->grid[ BOARD_INDEX( b, x, y ) ];
+    for ( unsigned char stone = BLACK_STONE; stone <= WHITE_STONE; stone++ ) {
+        const bool exact = cache->exact && stone == BLACK_STONE;
+        //The keys of the intersection skip it, so only the counters its patterns go to change.
+        //A stone of the other color kept none up to date
+        const int first = slot( cache, BOARD_CELL( b, x, y ), stone );
+        unsigned int* before = counters( cache, previous, stone );
+        unsigned int* after = counters( cache, content, stone );
+        for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+            unsigned char pattern = cache->patterns[ first + axis ];
+            if ( before == NULL ) {
+                pattern = pattern_of( cache->keys[ first + axis ], exact );
+                cache->patterns[ first + axis ] = pattern;
+            }
+            if ( before != NULL ) {
+                before[pattern]--;
+            }
+            if ( after != NULL ) {
+                after[pattern]++;
+            }
+        }
+
+        //Every key along an axis that reaches the intersection has its digit for it changed
+        const int digit = pattern_codes[stone][content] - pattern_codes[stone][previous];
+        if ( digit == 0 ) {
+            continue;
+        }
+        //Five or more wins without the exact rule, so a stone PATTERN_REACH away only matters to an overline
+        const int reach = exact ? PATTERN_REACH : PATTERN_REACH - 1;
+        for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+            //Every axis counts positions along its line up by one per step, like i below
+            unsigned char pos;
+            line_bits others = board_line( b, stone, axis, x, y, &pos );
+            others &= ~( ( line_bits ) 1 << pos );
+            const int cell_step = ( axis_dy[axis] * cache->size + axis_dx[axis] ) * NUM_AXES;
+            const int grid_step = axis_dy[axis] * b->stride + axis_dx[axis];
+            for ( int side = -1; side <= 1; side += 2 ) {
+                //Past a stone of the other color, the intersection is outside every five a neighbour can make
+                bool blocked = false;
+                int index = first + axis;
+                int at = BOARD_INDEX( b, x, y );
+                for ( int i = side; i >= -PATTERN_REACH && i <= PATTERN_REACH; i += side ) {
+                    index += side * cell_step;
+                    at += side * grid_step;
+                    //The padding is as wide as PATTERN_REACH, so the walk always stops on it at the edge
+                    const unsigned char neighbour = b->grid[at];
+                    if ( neighbour == BORDER_INTERSECTION ) {
+                        break;
+                    }
+                    //Seen from the neighbour, the intersection is i places before the center
+                    cache->keys[index] += digit * place_values[ PATTERN_REACH - i ];
+                    unsigned int* count = counters( cache, neighbour, stone );
+                    //With no other stone of the color in its window, a neighbour has at most two and no pattern either way
+                    const int p = pos + i;
+                    const line_bits around = p >= PATTERN_REACH ? WINDOW_BITS << ( p - PATTERN_REACH ) : WINDOW_BITS >> ( PATTERN_REACH - p );
+                    const bool alone = ( others & around & ~( ( line_bits ) 1 << p ) ) == 0;
+                    if ( !blocked && !alone && i * side <= reach && count != NULL ) {
+                        //Most changes leave the pattern as it was, and then there is nothing to count
+                        const unsigned char pattern = pattern_of( cache->keys[index], exact );
+                        if ( pattern != cache->patterns[index] ) {
+                            count[ cache->patterns[index] ]--;
+                            count[pattern]++;
+                            cache->patterns[index] = pattern;
+                        }
+                    }
+                    blocked |= neighbour != EMPTY_INTERSECTION && neighbour != stone;
+                }
+            }
+        }
+    }
+}
+
+void lines_assign( line_cache* cache, const line_cache* from )
+{
+    memcpy( cache->keys, from->keys, 2 * cache->size * cache->size * NUM_AXES * sizeof( unsigned short ) );
+    memcpy( cache->patterns, from->patterns, 2 * cache->size * cache->size * NUM_AXES * sizeof( unsigned char ) );
+    memcpy( cache->moves, from->moves, sizeof( cache->moves ) );
+    memcpy( cache->stones, from->stones, sizeof( cache->stones ) );
+}
+
+unsigned char lines_pattern( const line_cache* cache, unsigned char x, unsigned char y, unsigned char stone, unsigned char axis )
+{
+    return cache->patterns[ slot( cache, y * cache->size + x, stone ) + axis ];
+}
+
+static unsigned int* counters( line_cache* cache, unsigned char content, unsigned char stone )
+{
+    if ( content == EMPTY_INTERSECTION ) {
+        return cache->moves[stone - 1];
+    } else if ( content == stone ) {
+        return cache->stones[stone - 1];
+    }
+    return NULL;
+}
+
+static int slot( const line_cache* cache, int cell, unsigned char stone )
+{
+    return ( ( stone - 1 ) * cache->size * cache->size + cell ) * NUM_AXES;
+}
@@ -0,0 +1,79 @@
+#ifndef _LINES_H_
+#define _LINES_H_
+#include "board.h"
+#include "pattern.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The encoding and classification of every row, column and diagonal of a board, kept up to date one stone
+ * at a time. For each color, the cache holds the pattern key (see pattern_key) of every intersection along
+ * each axis, which encodes the line through it around that point. A stone only changes one digit of the
+ * keys of the PATTERN_REACH intersections on either side of it along its four lines, so updating is a
+ * few additions and table lookups. The counters add up the patterns of the empty intersections (the moves
+ * of a color) and of the stones of each color, so questions like how many open threes black can make are
+ * a lookup. keys[( ( stone - 1 ) * size * size + BOARD_CELL( b, x, y ) ) * NUM_AXES + axis] holds a key,
+ * and patterns at the same index its classification, except where the intersection holds a stone of the
+ * other color, whose patterns are only classified again once it is taken off.
+ */
+typedef struct {
+    unsigned char size;
+    bool exact;                          //True if black only makes a five with exactly five stones (renju)
+    unsigned short* keys;
+    unsigned char* patterns;
+    unsigned int moves[2][NUM_PATTERNS];  //Pairs of an empty intersection and an axis, by pattern
+    unsigned int stones[2][NUM_PATTERNS]; //Pairs of a stone of the color and an axis, by pattern
+} line_cache;
+
+/**
+ * Returns the number of bytes a cache for the given board size takes.
+ * @param size The size of the board, assumed to be valid.
+ * @return The size of the memory block lines_init needs.
+ */
+size_t lines_footprint(unsigned char size);
+
+/**
+ * Lays out a cache in the given memory, which the caller owns. The cache holds nothing until lines_rebuild.
+ * @param memory At least lines_footprint( size ) bytes, aligned like malloc memory.
+ * @param size The size of the board.
+ * @param exact True if black only makes a five with exactly five stones (renju).
+ * @return The cache, at the start of the memory.
+ */
+line_cache* lines_init(void* memory, unsigned char size, bool exact);
+
+/**
+ * Encodes and classifies every line of a board from scratch.
+ * @param cache The cache, of the size of the board.
+ * @param b Reference to the board.
+ */
+void lines_rebuild(line_cache* cache, const board* b);
+
+/**
+ * Encodes and classifies again the four lines through an intersection whose content changed.
+ * @param cache The cache, up to date with the board before the change.
+ * @param b Reference to the board, after the change.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param previous What the intersection held before the change.
+ */
+void lines_update(line_cache* cache, const board* b, unsigned char x, unsigned char y, unsigned char previous);
+
+/**
+ * Copies a cache into another of the same size.
+ * @param cache The cache to overwrite.
+ * @param from The cache to copy.
+ */
+void lines_assign(line_cache* cache, const line_cache* from);
+
+/**
+ * Returns the pattern a stone of the given color makes, or would make, at an intersection along one axis.
+ * Not kept up to date for an intersection that holds a stone of the other color.
+ * @param cache The cache.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param stone The color of the stone (BLACK_STONE or WHITE_STONE).
+ * @param axis The axis of the line.
+ * @return One of the PATTERN_ constants.
+ */
+unsigned char lines_pattern(const line_cache* cache, unsigned char x, unsigned char y, unsigned char stone, unsigned char axis);
+#endif
@@ -0,0 +1,101 @@
+#include "game.h"
+#include "io.h"
+#include "book.h"
+#include "error-codes.h"
+#include <string.h>
+
+/**
+ * Prints out the error message to the console if command line args are not correct.
+ */
+static void arg_error();
+
+/**
+ * Returns the name of a game type as the -type option takes it.
+ * @param type The game type (GAME_FREESTYLE or GAME_RENJU).
+ * @return The name of the type.
+ */
+static const char* type_name( unsigned char type );
+
+/**
+ * Builds an opening book from saved games in the text .gmk format. The board size and game type of the
+ * book are those of the first game unless set with -b and -type. Games of other sizes or types, and games
+ * that were stopped before a result, are skipped, and each one skipped is listed with the reason.
+ * Use -b followed by a number to set the board size of the book.
+ * Use -type followed by gomoku or renju to set the game type of the book.
+ * Use -moves followed by a number to set how many moves of each game go into the book (12 by default).
+ * Use -min followed by a number to keep only the moves played in at least that many games (1 by default).
+ * @param argc The total number of arguments.
+ * @param argv[] Array of arguments
+ * return 0 if successful.
+ */
+int main( int argc, char *argv[] ) {
+    int moves = BOOK_DEFAULT_MOVES;
+    int min_games = 1;
+    //Zero until set by an option or the first game
+    unsigned char size = 0;
+    unsigned char type = 0;
+    bool type_set = false;
+    
+    int i = 1;
+    for ( ; i + 1 < argc && argv[i][0] == '-'; i += 2 ) {
+        if ( strcmp( argv[i], "-b" ) == 0 ) {
+            size = atoi( argv[i + 1] );
+            if ( atoi( argv[i + 1] ) > BOARD_MAX_SIZE || !board_size_valid( size ) ) {
+                arg_error();
+            }
+        } else if ( strcmp( argv[i], "-type" ) == 0 && strcmp( argv[i + 1], "gomoku" ) == 0 ) {
+            type = GAME_FREESTYLE;
+            type_set = true;
+        } else if ( strcmp( argv[i], "-type" ) == 0 && strcmp( argv[i + 1], "renju" ) == 0 ) {
+            type = GAME_RENJU;
+            type_set = true;
+        } else if ( strcmp( argv[i], "-moves" ) == 0 ) {
+            moves = atoi( argv[i + 1] );
+        } else if ( strcmp( argv[i], "-min" ) == 0 ) {
+            min_games = atoi( argv[i + 1] );
+        } else {
+            arg_error();
+        }
+    }
+    if ( argc - i < 2 || moves <= 0 || moves > BOOK_MAX_MOVES || min_games <= 0 ) {
+        arg_error();
+    }
+    
+    const char* path = argv[i++];
+    book_builder* w = NULL;
+    int added = 0;
+    int skipped = 0;
+    for ( ; i < argc; i++ ) {
+        game* g = game_import( argv[i] );
+        if ( w == NULL ) {
+            w = book_builder_create( size != 0 ? size : g->board->size, type_set ? type : g->type, moves );
+        }
+        if ( book_add( w, g ) ) {
+            added++;
+        } else {
+            skipped++;
+            if ( g->board->size != w->size ) {
+                fprintf( stderr, "Skipped %s: board size %d, the book is for %d\n", argv[i], g->board->size, w->size );
+            } else if ( g->type != w->type ) {
+                fprintf( stderr, "Skipped %s: %s game, the book is for %s\n", argv[i], type_name( g->type ), type_name( w->type ) );
+            } else {
+                fprintf( stderr, "Skipped %s: the game has no result\n", argv[i] );
+            }
+        }
+        game_delete( g );
+    }
+    uint32_t entries = book_builder_close( w, path, min_games );
+    printf( "%d games added to %s (%u moves kept), %d skipped\n", added, path, entries, skipped );
+    return 0;
+}
+
+static void arg_error() {
+    printf( "usage: ./openbook [-b <15-64>] [-type <gomoku|renju>] [-moves <count>] [-min <games>]\n"
+            "                  <book.gmo> <saved-match.gmk>...\n" );
+    exit( ARGUMENT_ERR );
+}
+
+static const char* type_name( unsigned char type )
+{
+    return type == GAME_RENJU ? "renju" : "gomoku";
+}
@@ -0,0 +1,38 @@
+#include "game.h"
+#include "io.h"
+#include "archive.h"
+#include "error-codes.h"
+#include <string.h>
+
+/**
+ * Prints out the error message to the console if command line args are not correct.
+ */
+static void arg_error();
+
+/**
+ * Packs saved games in the text .gmk format into one binary archive.
+ * The games are stored in the order given.
+ * @param argc The total number of arguments.
+ * @param argv[] Array of arguments
+ * return 0 if successful.
+ */
+int main( int argc, char *argv[] ) {
+    if ( argc < 3 ) {
+        arg_error();
+    }
+    
+    archive_writer* w = archive_writer_create( argv[1] );
+    for ( int i = 2; i < argc; i++ ) {
+        game* g = game_import( argv[i] );
+        archive_write( w, g );
+        game_delete( g );
+    }
+    archive_writer_close( w );
+    printf( "%d games packed into %s\n", argc - 2, argv[1] );
+    return 0;
+}
+
+static void arg_error() {
+    printf( "usage: ./pack <archive.gmb> <saved-match.gmk>...\n" );
+    exit( ARGUMENT_ERR );
+}
@@ -0,0 +1,177 @@
+#include "pattern.h"
+#include "board.h"
+#include <pthread.h>
+#define CODE_EMPTY 0
+#define CODE_OWN 1
+#define CODE_BLOCKED 2
+#define FIVE_STONES 5
+#define CENTER PATTERN_REACH
+#define WINDOW_CELLS ( PATTERN_WINDOW + 1 )
+
+/**
+ * Classification of every key, for exact five rules and for five-or-more rules.
+ */
+static unsigned char patterns_exact[PATTERN_KEYS];
+static unsigned char patterns_free[PATTERN_KEYS];
+static pthread_once_t initialized = PTHREAD_ONCE_INIT;
+
+/**
+ * Place value of each cell of the window in the key, skipping the center.
+ */
+static const unsigned short powers[PATTERN_WINDOW] = { 1, 3, 9, 27, 81, 243, 729, 2187, 6561, 19683 };
+
+const unsigned char pattern_codes[3][4] = {
+    { CODE_EMPTY, CODE_BLOCKED, CODE_BLOCKED, CODE_BLOCKED },
+    { CODE_EMPTY, CODE_OWN, CODE_BLOCKED, CODE_BLOCKED },
+    { CODE_EMPTY, CODE_BLOCKED, CODE_OWN, CODE_BLOCKED }
+};
+
+/**
+ * Counts the unbroken run of own stones through the center of a decoded window.
+ * @param w The decoded window of WINDOW_CELLS codes.
+ * @return The length of the run, including the center.
+ */
+static unsigned char run_through_center( const unsigned char* w );
+
+/**
+ * Classifies a decoded window by its five and four patterns only.
+ * @param w The decoded window of WINDOW_CELLS codes.
+ * @param exact True if only exactly five stones make a five.
+ * @return PATTERN_FIVE, PATTERN_OVERLINE, PATTERN_OPEN_FOUR, PATTERN_DOUBLE_FOUR, PATTERN_FOUR or PATTERN_NONE.
+ */
+static unsigned char classify_fours( unsigned char* w, bool exact );
+
+/**
+ * Classifies a decoded window, including threes that one more stone turns into a four.
+ * @param w The decoded window of WINDOW_CELLS codes.
+ * @param exact True if only exactly five stones make a five.
+ * @return One of the PATTERN_ constants.
+ */
+static unsigned char classify( unsigned char* w, bool exact );
+
+/**
+ * Classifies every key into both tables. Run once by pattern_init.
+ */
+static void build_tables();
+
+void pattern_init()
+{
+    //Games can be created on several threads at once, so the first call builds the tables and the others wait
+    pthread_once( &initialized, build_tables );
+}
+
+static void build_tables()
+{
+    unsigned char w[WINDOW_CELLS];
+    for ( int key = 0; key < PATTERN_KEYS; key++ ) {
+        //Decode the key around an own stone at the center
+        int rest = key;
+        for ( int i = 0; i < PATTERN_WINDOW; i++ ) {
+            w[ i < CENTER ? i : i + 1 ] = rest % 3;
+            rest /= 3;
+        }
+        w[CENTER] = CODE_OWN;
+        patterns_exact[key] = classify( w, true );
+        patterns_free[key] = classify( w, false );
+    }
+}
+
+unsigned short pattern_key( const board* b, unsigned char x, unsigned char y, unsigned char stone, unsigned char axis )
+{
+    //The board keeps PATTERN_REACH rings of sentinels, so the window never leaves the grid
+    const unsigned char* code = pattern_codes[stone];
+    const int step = b->step[axis];
+    int cell = BOARD_INDEX( b, x, y ) - PATTERN_REACH * step;
+    unsigned short key = 0;
+    for ( int i = 0; i < PATTERN_WINDOW; i++ ) {
+        if ( i == CENTER ) {
+            cell += step;
+        }
+        key += code[ b->grid[cell] ] * powers[i];
+        cell += step;
+    }
+    return key;
+}
+
+unsigned char pattern_of( unsigned short key, bool exact )
+{
+    return exact ? patterns_exact[key] : patterns_free[key];
+}
+
+void pattern_classify( const board* b, unsigned char x, unsigned char y, unsigned char stone, bool exact, unsigned char* patterns )
+{
+    for ( unsigned char axis = 0; axis < NUM_AXES; axis++ ) {
+        patterns[axis] = pattern_of( pattern_key( b, x, y, stone, axis ), exact );
+    }
+}
+
+static unsigned char run_through_center( const unsigned char* w )
+{
+    unsigned char run = 1;
+    for ( int i = CENTER + 1; i < WINDOW_CELLS && w[i] == CODE_OWN; i++ ) {
+        run++;
+    }
+    for ( int i = CENTER - 1; i >= 0 && w[i] == CODE_OWN; i-- ) {
+        run++;
+    }
+    return run;
+}
+
+static unsigned char classify_fours( unsigned char* w, bool exact )
+{
+    unsigned char run = run_through_center( w );
+    if ( run == FIVE_STONES || ( run > FIVE_STONES && !exact ) ) {
+        return PATTERN_FIVE;
+    } else if ( run > FIVE_STONES ) {
+        return PATTERN_OVERLINE;
+    }
+    //Find every empty intersection that completes a five through the center
+    int points[WINDOW_CELLS];
+    int num_points = 0;
+    for ( int i = CENTER - FIVE_STONES + 1; i < CENTER + FIVE_STONES; i++ ) {
+        if ( w[i] == CODE_EMPTY ) {
+            w[i] = CODE_OWN;
+            run = run_through_center( w );
+            if ( run == FIVE_STONES || ( run > FIVE_STONES && !exact ) ) {
+                points[num_points++] = i;
+            }
+            w[i] = CODE_EMPTY;
+        }
+    }
+    //Two completions on either end of the same four stones make it open
+    for ( int i = 0; i < num_points; i++ ) {
+        for ( int j = i + 1; j < num_points; j++ ) {
+            if ( points[j] - points[i] == FIVE_STONES ) {
+                return PATTERN_OPEN_FOUR;
+            }
+        }
+    }
+    if ( num_points > 1 ) {
+        return PATTERN_DOUBLE_FOUR;
+    } else if ( num_points == 1 ) {
+        return PATTERN_FOUR;
+    }
+    return PATTERN_NONE;
+}
+
+static unsigned char classify( unsigned char* w, bool exact )
+{
+    unsigned char pattern = classify_fours( w, exact );
+    if ( pattern != PATTERN_NONE ) {
+        return pattern;
+    }
+    //A three is one stone away from a four, an open three one stone away from an open four
+    for ( int i = CENTER - FIVE_STONES + 1; i < CENTER + FIVE_STONES; i++ ) {
+        if ( w[i] == CODE_EMPTY ) {
+            w[i] = CODE_OWN;
+            unsigned char next = classify_fours( w, exact );
+            w[i] = CODE_EMPTY;
+            if ( next == PATTERN_OPEN_FOUR ) {
+                return PATTERN_OPEN_THREE;
+            } else if ( next == PATTERN_FOUR || next == PATTERN_DOUBLE_FOUR ) {
+                pattern = PATTERN_THREE;
+            }
+        }
+    }
+    return pattern;
+}
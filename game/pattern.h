@@ -0,0 +1,64 @@
+#ifndef _PATTERN_H_
+#define _PATTERN_H_
+#include "board.h"
+#include <stdbool.h>
+#define PATTERN_NONE 0
+#define PATTERN_THREE 1
+#define PATTERN_OPEN_THREE 2
+#define PATTERN_FOUR 3
+#define PATTERN_DOUBLE_FOUR 4
+#define PATTERN_OPEN_FOUR 5
+#define PATTERN_FIVE 6
+#define PATTERN_OVERLINE 7
+#define NUM_PATTERNS 8
+#define PATTERN_REACH 5
+#define PATTERN_WINDOW ( 2 * PATTERN_REACH )
+#define PATTERN_KEYS 59049
+
+/**
+ * Base 3 digit of an intersection in a key, indexed by the color at the center and then by the intersection state.
+ */
+extern const unsigned char pattern_codes[3][4];
+
+/**
+ * Builds the pattern lookup tables. Every window of PATTERN_REACH intersections on either side of a
+ * stone is encoded in base 3 (empty, own stone, opponent stone or border) and classified once, for
+ * both exact five rules (black in renju) and five-or-more rules. Safe to call more than once and from
+ * several threads at once, the tables are only built the first time.
+ */
+void pattern_init();
+
+/**
+ * Encodes the window around the given intersection along one axis as a table key. The intersection
+ * itself is treated as holding a stone of the given color whether or not it is occupied, so the key
+ * also describes the line a move at an empty intersection would create. Coordinates are not bounds checked.
+ * @param b Reference to the current board.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param stone The color of the stone at the center of the window.
+ * @param axis The axis of the line to encode.
+ * @return The key of the window, from 0 to PATTERN_KEYS - 1.
+ */
+unsigned short pattern_key(const board* b, unsigned char x, unsigned char y, unsigned char stone, unsigned char axis);
+
+/**
+ * Classifies an encoded window. pattern_init must have been called. The window alone cannot tell whether
+ * the point that turns an open three into an open four is forbidden for black, so a false three of renju
+ * is classified as open too; the renju move check (rules.h) tells them apart.
+ * @param key The key returned by pattern_key.
+ * @param exact True if only exactly five stones make a five (black in renju), false if six or more also do.
+ * @return The strongest pattern the center stone is part of, one of the PATTERN_ constants.
+ */
+unsigned char pattern_of(unsigned short key, bool exact);
+
+/**
+ * Classifies the lines along all four axes through the given intersection with four table lookups.
+ * @param b Reference to the current board.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param stone The color of the stone at the center of the lines.
+ * @param exact True if only exactly five stones make a five, false if six or more also do.
+ * @param patterns Array of NUM_AXES where the pattern along each axis is stored.
+ */
+void pattern_classify(const board* b, unsigned char x, unsigned char y, unsigned char stone, bool exact, unsigned char* patterns);
+#endif
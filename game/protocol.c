@@ -0,0 +1,255 @@
+#include "protocol.h"
+#include "engine.h"
+#include "game.h"
+#include "board.h"
+#include <stdarg.h>
+#include <string.h>
+
+/**
+ * State of a protocol session: the game in progress and the time allowed per move.
+ */
+typedef struct {
+    unsigned char type;
+    game* g;
+    engine_limits limits;
+    long timeout_turn;
+    long time_left;
+} session;
+
+/**
+ * Prints one reply line and flushes it.
+ * @param format The printf format of the line, without the newline.
+ */
+static void reply( const char* format, ... );
+
+/**
+ * Starts a new game of the given size, replacing the current one.
+ * @param s The session.
+ * @param size The board size.
+ * @param forget True to also clear the transposition table, for a new match rather than a new position.
+ * @return True if the size is supported.
+ */
+static bool start( session* s, int size, bool forget );
+
+/**
+ * Reads "x,y" coordinates and checks that they are on the board.
+ * @param s The session.
+ * @param text The text to read.
+ * @param x Reference to the location where the horizontal coordinate is stored.
+ * @param y Reference to the location where the vertical coordinate is stored.
+ * @return True if the coordinates were read and are on the board.
+ */
+static bool read_coord( const session* s, const char* text, unsigned char* x, unsigned char* y );
+
+/**
+ * Picks and plays a move for the side to move, and replies with it.
+ * @param s The session.
+ */
+static void play( session* s );
+
+/**
+ * Reads the stones following a BOARD command up to DONE, places them, and replies with a move.
+ * @param s The session.
+ */
+static void read_board( session* s );
+
+void protocol_loop( unsigned char type, const engine_limits* limits )
+{
+    session s;
+    s.type = type;
+    s.g = NULL;
+    s.limits = *limits;
+    s.timeout_turn = 0;
+    s.time_left = 0;
+
+    char line[PROTOCOL_LINE_LENGTH];
+    unsigned char x;
+    unsigned char y;
+    int size;
+    while ( fgets( line, PROTOCOL_LINE_LENGTH, stdin ) != NULL ) {
+        //Commands are case insensitive and may end with \r\n
+        line[ strcspn( line, "\r\n" ) ] = '\0';
+        char* args = line + strcspn( line, " " );
+        if ( *args != '\0' ) {
+            *args++ = '\0';
+        }
+        for ( char* c = line; *c; c++ ) {
+            if ( *c >= 'a' && *c <= 'z' ) {
+                *c = *c - 'a' + 'A';
+            }
+        }
+
+        if ( strcmp( line, "START" ) == 0 ) {
+            if ( sscanf( args, "%d", &size ) == 1 && start( &s, size, true ) ) {
+                reply( "OK" );
+            } else {
+                reply( "ERROR unsupported board size" );
+            }
+        } else if ( strcmp( line, "RESTART" ) == 0 ) {
+            if ( s.g != NULL && start( &s, s.g->board->size, true ) ) {
+                reply( "OK" );
+            } else {
+                reply( "ERROR no game started" );
+            }
+        } else if ( s.g == NULL && ( strcmp( line, "BEGIN" ) == 0 || strcmp( line, "TURN" ) == 0 ||
+                                     strcmp( line, "TAKEBACK" ) == 0 || strcmp( line, "BOARD" ) == 0 ) ) {
+            reply( "ERROR no game started" );
+        } else if ( strcmp( line, "BEGIN" ) == 0 ) {
+            play( &s );
+        } else if ( strcmp( line, "TURN" ) == 0 ) {
+            if ( !read_coord( &s, args, &x, &y ) || !game_make_move( s.g, x, y ) ) {
+                reply( "ERROR invalid move" );
+            } else {
+                play( &s );
+            }
+        } else if ( strcmp( line, "TAKEBACK" ) == 0 ) {
+            size_t num_moves = s.g->moves_count;
+            if ( read_coord( &s, args, &x, &y ) && num_moves > 0 &&
+                 s.g->moves[num_moves - 1].x == x && s.g->moves[num_moves - 1].y == y ) {
+                game_unmake_move( s.g );
+                reply( "OK" );
+            } else {
+                reply( "ERROR not the last move" );
+            }
+        } else if ( strcmp( line, "BOARD" ) == 0 ) {
+            read_board( &s );
+        } else if ( strcmp( line, "INFO" ) == 0 ) {
+            //Only the time settings matter, other keys are ignored
+            char key[PROTOCOL_LINE_LENGTH];
+            long value;
+            if ( sscanf( args, "%255s %ld", key, &value ) == 2 ) {
+                if ( strcmp( key, "timeout_turn" ) == 0 ) {
+                    s.timeout_turn = value;
+                } else if ( strcmp( key, "time_left" ) == 0 ) {
+                    s.time_left = value;
+                }
+            }
+        } else if ( strcmp( line, "END" ) == 0 ) {
+            break;
+        } else if ( strcmp( line, "ABOUT" ) == 0 ) {
+            reply( "name=\"%s\", version=\"1.0\", author=\"Joe Hummer\"", s.type == GAME_RENJU ? "renju" : "gomoku" );
+        } else if ( line[0] != '\0' ) {
+            reply( "UNKNOWN command %s", line );
+        }
+    }
+
+    if ( s.g != NULL ) {
+        game_delete( s.g );
+    }
+}
+
+static void reply( const char* format, ... )
+{
+    va_list args;
+    va_start( args, format );
+    vprintf( format, args );
+    va_end( args );
+    printf( "\n" );
+    fflush( stdout );
+}
+
+static bool start( session* s, int size, bool forget )
+{
+    if ( size < 0 || size > BOARD_MAX_SIZE || !board_size_valid( size ) ) {
+        return false;
+    }
+    if ( s->g != NULL ) {
+        game_delete( s->g );
+    }
+    s->g = game_create( size, s->type );
+    if ( forget && s->limits.table != NULL ) {
+        tt_clear( s->limits.table );
+    }
+    return true;
+}
+
+static bool read_coord( const session* s, const char* text, unsigned char* x, unsigned char* y )
+{
+    int col;
+    int row;
+    if ( sscanf( text, "%d,%d", &col, &row ) != 2 ) {
+        return false;
+    } else if ( col < 0 || col >= s->g->board->size || row < 0 || row >= s->g->board->size ) {
+        return false;
+    }
+    *x = col;
+    *y = row;
+    return true;
+}
+
+static void play( session* s )
+{
+    //Leave a margin for the reply, and spread the remaining match time over the moves to come
+    engine_limits limits = s->limits;
+    if ( s->timeout_turn > 0 ) {
+        long budget = s->timeout_turn > 2 * PROTOCOL_TIME_MARGIN ? s->timeout_turn - PROTOCOL_TIME_MARGIN : s->timeout_turn / 2;
+        if ( limits.time_ms == 0 || budget < ( long )limits.time_ms ) {
+            limits.time_ms = budget > 0 ? budget : 1;
+        }
+    }
+    if ( s->time_left > 0 && ( limits.time_ms == 0 || s->time_left / PROTOCOL_MOVES_LEFT < ( long )limits.time_ms ) ) {
+        limits.time_ms = s->time_left / PROTOCOL_MOVES_LEFT > 0 ? s->time_left / PROTOCOL_MOVES_LEFT : 1;
+    }
+
+    engine_result result;
+    if ( s->g->state != GAME_STATE_PLAYING || !engine_search( s->g, &limits, &result ) ) {
+        reply( "ERROR the game is over" );
+        return;
+    }
+    game_make_move( s->g, result.x, result.y );
+    reply( "%d,%d", result.x, result.y );
+}
+
+static void read_board( session* s )
+{
+    //Own stones are field 1 and the opponent's field 2, each kept in the order given
+    move own[BOARD_MAX_SIZE * BOARD_MAX_SIZE];
+    move opponent[BOARD_MAX_SIZE * BOARD_MAX_SIZE];
+    int num_own = 0;
+    int num_opponent = 0;
+    bool valid = true;
+    char line[PROTOCOL_LINE_LENGTH];
+    while ( fgets( line, PROTOCOL_LINE_LENGTH, stdin ) != NULL ) {
+        line[ strcspn( line, "\r\n" ) ] = '\0';
+        if ( strcmp( line, "DONE" ) == 0 || strcmp( line, "done" ) == 0 ) {
+            break;
+        }
+        int col;
+        int row;
+        int field;
+        int max = s->g->board->size * s->g->board->size;
+        if ( sscanf( line, "%d,%d,%d", &col, &row, &field ) != 3 || col < 0 || col >= s->g->board->size ||
+             row < 0 || row >= s->g->board->size || num_own + num_opponent >= max ) {
+            valid = false;
+        } else if ( field == 1 ) {
+            own[num_own].x = col;
+            own[num_own++].y = row;
+        } else if ( field == 2 ) {
+            opponent[num_opponent].x = col;
+            opponent[num_opponent++].y = row;
+        } else {
+            valid = false;
+        }
+    }
+
+    //The side to move has as many stones as the other if it is black, one fewer if it is white
+    start( s, s->g->board->size, false );
+    if ( num_opponent != num_own && num_opponent != num_own + 1 ) {
+        valid = false;
+    }
+    move* black = num_opponent == num_own ? own : opponent;
+    move* white = num_opponent == num_own ? opponent : own;
+    int num_black = num_opponent == num_own ? num_own : num_opponent;
+    int num_white = num_opponent == num_own ? num_opponent : num_own;
+    for ( int i = 0; valid && i < num_black; i++ ) {
+        valid = game_make_move( s->g, black[i].x, black[i].y );
+        if ( valid && i < num_white ) {
+            valid = game_make_move( s->g, white[i].x, white[i].y );
+        }
+    }
+    if ( !valid ) {
+        reply( "ERROR invalid board" );
+        return;
+    }
+    play( s );
+}
@@ -0,0 +1,18 @@
+#ifndef _PROTOCOL_H_
+#define _PROTOCOL_H_
+#include "engine.h"
+#define PROTOCOL_LINE_LENGTH 256
+#define PROTOCOL_TIME_MARGIN 50
+#define PROTOCOL_MOVES_LEFT 20
+
+/**
+ * Plays games over the line-based protocol of the Gomocup tournament manager (piskvork) on the standard
+ * input and output, until END or the end of the input. Coordinates are "x,y" counted from 0.
+ * Supported commands are START, RESTART, BEGIN, TURN, TAKEBACK, BOARD, INFO, END and ABOUT. Moves are
+ * picked with engine_search, checked with game_make_move, and every reply is flushed right away.
+ * The timeout_turn and time_left settings of INFO shorten the search time given in limits.
+ * @param type The game type played (GAME_FREESTYLE or GAME_RENJU).
+ * @param limits The search limits and transposition table of the engine.
+ */
+void protocol_loop(unsigned char type, const engine_limits* limits);
+#endif
@@ -10,28 +10,101 @@
 static void arg_error();
 
 
+/**
+ * Reads a comma separated list of move numbers, such as 10,20,35.
+ * @param list The list to read.
+ * @param count Reference to the location where the number of moves read is stored.
+ * @return A newly allocated array of the move numbers. Exits with ARGUMENT_ERR if the list is malformed.
+ */
+static size_t* parse_moves( const char* list, size_t* count );
+
 /**
  * Replays a given game from a saved file.
  * Displays each move with a list of moves so far.
  * Plays one move per second.
+ * Use -delay followed by a number of milliseconds to change the pause after each move, or -ff for no pause.
+ * Use -seek followed by a move number to start showing the game from that move.
+ * Use -final to show only the final position, or -moves followed by a list such as 10,20,35 to show only those moves.
+ * Use -draw followed by diff to repaint only the intersections that changed each move (full by default).
  * @param argc The total number of arguments.
  * @param argv[] Array of arguments
  * return 0 if successful.
  */
 int main( int argc, char *argv[] ) {
+    replay_options options = { REPLAY_DEFAULT_DELAY, 0, false, NULL, 0, false };
+    size_t* selected = NULL;
     
-    if ( argc != 2 ) {
+    int i = 1;
+    for ( ; i < argc - 1 && argv[i][0] == '-'; i++ ) {
+        if ( strcmp( argv[i], "-ff" ) == 0 ) {
+            options.delay_ms = 0;
+        } else if ( strcmp( argv[i], "-final" ) == 0 ) {
+            options.final_only = true;
+        } else if ( i + 2 >= argc ) {
+            arg_error();
+        } else if ( strcmp( argv[i], "-delay" ) == 0 ) {
+            options.delay_ms = strtoul( argv[++i], NULL, 10 );
+        } else if ( strcmp( argv[i], "-seek" ) == 0 ) {
+            options.seek = strtoul( argv[++i], NULL, 10 );
+        } else if ( strcmp( argv[i], "-draw" ) == 0 ) {
+            i++;
+            if ( strcmp( argv[i], "diff" ) == 0 ) {
+                options.diff = true;
+            } else if ( strcmp( argv[i], "full" ) == 0 ) {
+                options.diff = false;
+            } else {
+                arg_error();
+            }
+        } else if ( strcmp( argv[i], "-moves" ) == 0 ) {
+            free( selected );
+            selected = parse_moves( argv[++i], &options.num_selected );
+            options.selected = selected;
+        } else {
+            arg_error();
+        }
+    }
+    if ( i != argc - 1 ) {
         arg_error();
     }
     
-    char* path = argv[1];
+    char* path = argv[i];
     game* g = game_import( path );
-    game_replay( g );
+    game_replay( g, &options );
     
+    game_delete( g );
+    free( selected );
     return 0;
 }
 
+static size_t* parse_moves( const char* list, size_t* count )
+{
+    //One number per comma, plus the last
+    size_t capacity = 1;
+    for ( const char* c = list; *c; c++ ) {
+        if ( *c == ',' ) {
+            capacity++;
+        }
+    }
+    size_t* moves = ( size_t * )malloc( capacity * sizeof( size_t ) );
+    if (moves == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    *count = 0;
+    const char* c = list;
+    while ( *count < capacity ) {
+        char* end;
+        unsigned long number = strtoul( c, &end, 10 );
+        if ( end == c || number == 0 || ( *end != ',' && *end != '\0' ) ) {
+            arg_error();
+        }
+        moves[( *count )++] = number;
+        c = end + 1;
+    }
+    return moves;
+}
+
 static void arg_error() {
-    printf( "usage: ./replay <saved-match.gmk>\n" );
+    printf( "usage: ./replay [-delay <ms>] [-ff] [-seek <move>] [-final] [-moves <move,move,...>] [-draw <full|diff>] <saved-match.gmk>\n" );
     exit( ARGUMENT_ERR );
-}
\ No newline at end of file
+}
@@ -0,0 +1,311 @@
+#include "rules.h"
+#include "pattern.h"
+#include <string.h>
+#define KERNEL static inline __attribute__((always_inline))
+#define STRIDE( size ) ( ( size ) + 2 * BOARD_PADDING )
+#define CENTER( stride, x, y ) ( ( ( y ) + BOARD_PADDING ) * ( stride ) + ( x ) + BOARD_PADDING )
+#define MAX_THREE_DEPTH 6
+
+/**
+ * Finds the longest run of stones through an intersection over all four axes with the line bitboards,
+ * counting the intersection as one of the stones whatever it holds.
+ * @param b Reference to the board.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param stone The color of the run.
+ * @return The length of the longest run.
+ */
+KERNEL unsigned char longest_run( const board* b, unsigned char x, unsigned char y, unsigned char stone )
+{
+    unsigned char longest = 0;
+    unsigned char pos;
+    for ( unsigned char axis = 0; axis < NUM_AXES; axis++ ) {
+        line_bits bits = board_line( b, stone, axis, x, y, &pos );
+        bits |= ( line_bits ) 1 << pos;
+        unsigned char run = board_run_length( bits, pos );
+        if ( run > longest ) {
+            longest = run;
+        }
+    }
+    return longest;
+}
+
+/**
+ * Checks for five or more in a row through a move, the rule of freestyle and of white in renju.
+ * @param b Reference to the board.
+ * @param x The horizontal coordinate of the move.
+ * @param y The vertical coordinate of the move.
+ * @param stone The color of the move.
+ * @return GAME_STATE_FINISHED if the move wins, GAME_STATE_PLAYING otherwise.
+ */
+KERNEL unsigned char check_five( const board* b, unsigned char x, unsigned char y, unsigned char stone )
+{
+    return longest_run( b, x, y, stone ) >= FIVE_IN_A_ROW ? GAME_STATE_FINISHED : GAME_STATE_PLAYING;
+}
+
+/**
+ * Encodes the window around an intersection along one axis, like pattern_key.
+ * @param grid The padded grid.
+ * @param center The grid index of the intersection.
+ * @param step The index delta of one move along the axis.
+ * @param code The base 3 digits for the color at the center, a row of pattern_codes.
+ * @return The key of the window.
+ */
+KERNEL unsigned short window_key( const unsigned char* grid, int center, int step, const unsigned char* code )
+{
+    unsigned short key = 0;
+    unsigned short power = 1;
+    for ( int i = -PATTERN_REACH; i <= PATTERN_REACH; i++ ) {
+        if ( i != 0 ) {
+            key += code[ grid[ center + i * step ] ] * power;
+            power *= 3;
+        }
+    }
+    return key;
+}
+
+/**
+ * Classifies the lines along all four axes through an intersection, like pattern_classify.
+ * @param grid The padded grid.
+ * @param center The grid index of the intersection.
+ * @param stride The width of the padded grid.
+ * @param stone The color of the stone at the center of the lines.
+ * @param exact True if only exactly five stones make a five.
+ * @param patterns Array of NUM_AXES where the pattern along each axis is stored.
+ */
+KERNEL void classify_lines( const unsigned char* grid, int center, int stride, unsigned char stone, bool exact, unsigned char* patterns )
+{
+    const unsigned char* code = pattern_codes[stone];
+    patterns[AXIS_HORIZONTAL] = pattern_of( window_key( grid, center, 1, code ), exact );
+    patterns[AXIS_VERTICAL] = pattern_of( window_key( grid, center, stride, code ), exact );
+    patterns[AXIS_DIAGONAL] = pattern_of( window_key( grid, center, stride + 1, code ), exact );
+    patterns[AXIS_ANTIDIAGONAL] = pattern_of( window_key( grid, center, 1 - stride, code ), exact );
+}
+
+/**
+ * Counts the black stones in a row through an intersection along one axis of the grid, the intersection included.
+ * @param grid The padded grid.
+ * @param center The grid index of the intersection.
+ * @param step The index delta of one move along the axis.
+ * @return The length of the run.
+ */
+KERNEL unsigned char grid_run( const unsigned char* grid, int center, int step )
+{
+    unsigned char run = 1;
+    for ( int i = center + step; grid[i] == BLACK_STONE; i += step ) {
+        run++;
+    }
+    for ( int i = center - step; grid[i] == BLACK_STONE; i -= step ) {
+        run++;
+    }
+    return run;
+}
+
+static bool forbidden_shape( unsigned char* grid, int center, int stride, int depth );
+
+/**
+ * Checks whether an open three of black can really become an open four: an empty intersection on its line
+ * makes it one and is not forbidden itself. A three whose every such point is forbidden is a false three.
+ * @param grid A copy of the padded grid holding the black stone at center, changed while checking and restored.
+ * @param center The grid index of a stone of the three.
+ * @param stride The width of the padded grid.
+ * @param step The index delta of one move along the axis of the three.
+ * @param depth The number of stones placed to get here, which bounds the checks of the points.
+ * @return True if the three is real.
+ */
+static bool real_three( unsigned char* grid, int center, int stride, int step, int depth )
+{
+    for ( int i = -( FIVE_IN_A_ROW - 1 ); i < FIVE_IN_A_ROW; i++ ) {
+        int point = center + i * step;
+        if ( i == 0 || grid[point] != EMPTY_INTERSECTION ) {
+            continue;
+        }
+        grid[point] = BLACK_STONE;
+        bool real = pattern_of( window_key( grid, center, step, pattern_codes[BLACK_STONE] ), true ) == PATTERN_OPEN_FOUR &&
+                    !forbidden_shape( grid, point, stride, depth + 1 );
+        grid[point] = EMPTY_INTERSECTION;
+        if ( real ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks whether the black stone at an intersection of the grid makes a forbidden shape, counting only the
+ * open threes that are real. Past MAX_THREE_DEPTH stones placed, every open three counts as real.
+ * @param grid A copy of the padded grid holding the black stone at center, changed while checking and restored.
+ * @param center The grid index of the stone.
+ * @param stride The width of the padded grid.
+ * @param depth The number of stones placed to get here.
+ * @return True if the stone makes an overline, two fours or two real open threes without an exact five.
+ */
+static bool forbidden_shape( unsigned char* grid, int center, int stride, int depth )
+{
+    const int steps[NUM_AXES] = { 1, stride, stride + 1, 1 - stride };
+    bool overline = false;
+    for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+        unsigned char run = grid_run( grid, center, steps[axis] );
+        if ( run == FIVE_IN_A_ROW ) {
+            return false;
+        }
+        overline |= run > FIVE_IN_A_ROW;
+    }
+    if ( overline ) {
+        return true;
+    }
+    unsigned char patterns[NUM_AXES];
+    unsigned char fours = 0;
+    unsigned char open_threes = 0;
+    classify_lines( grid, center, stride, BLACK_STONE, true, patterns );
+    for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+        if ( patterns[axis] == PATTERN_DOUBLE_FOUR ) {
+            fours += 2;
+        } else if ( patterns[axis] == PATTERN_FOUR || patterns[axis] == PATTERN_OPEN_FOUR ) {
+            fours++;
+        } else if ( patterns[axis] == PATTERN_OPEN_THREE ) {
+            open_threes++;
+        }
+    }
+    if ( fours > MAX_FOURS ) {
+        return true;
+    } else if ( open_threes <= MAX_OPEN_THREES || depth >= MAX_THREE_DEPTH ) {
+        return open_threes > MAX_OPEN_THREES;
+    }
+    //Only now that it matters, find out which threes are real
+    open_threes = 0;
+    for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+        if ( patterns[axis] == PATTERN_OPEN_THREE && real_three( grid, center, stride, steps[axis], depth ) ) {
+            open_threes++;
+        }
+    }
+    return open_threes > MAX_OPEN_THREES;
+}
+
+/**
+ * Checks a black move that makes two or more open threes and no other forbidden shape, on a copy of the grid
+ * since the points of the threes are tried with stones on them.
+ * @param b Reference to the board.
+ * @param center The grid index of the move.
+ * @param stride The width of the padded grid.
+ * @return True if at least two of the threes are real.
+ */
+static bool double_three( const board* b, int center, int stride )
+{
+    unsigned char grid[ STRIDE( BOARD_MAX_SIZE ) * STRIDE( BOARD_MAX_SIZE ) ];
+    memcpy( grid, b->grid, stride * stride );
+    grid[center] = BLACK_STONE;
+    return forbidden_shape( grid, center, stride, 0 );
+}
+
+/**
+ * Checks a renju move: white wins with five or more, black only with an exact five, and any other black
+ * move that makes an overline, two fours or two open threes is forbidden. Fives and overlines are found
+ * on the bitboards, fours and threes with the pattern tables. An open three only counts if a point that
+ * makes it an open four is not forbidden itself (no false threes).
+ * @param b Reference to the board.
+ * @param x The horizontal coordinate of the move.
+ * @param y The vertical coordinate of the move.
+ * @param center The grid index of the move.
+ * @param stride The width of the padded grid.
+ * @param stone The color of the move.
+ * @return GAME_STATE_FINISHED if the move wins, GAME_STATE_FORBIDDEN if it is forbidden, GAME_STATE_PLAYING otherwise.
+ */
+KERNEL unsigned char check_renju( const board* b, unsigned char x, unsigned char y, int center, int stride, unsigned char stone )
+{
+    if ( stone == WHITE_STONE ) {
+        return check_five( b, x, y, stone );
+    }
+    //An exact five wins even if the move also makes a forbidden shape
+    bool overline = false;
+    unsigned char pos;
+    for ( unsigned char axis = 0; axis < NUM_AXES; axis++ ) {
+        line_bits bits = board_line( b, BLACK_STONE, axis, x, y, &pos );
+        bits |= ( line_bits ) 1 << pos;
+        unsigned char run = board_run_length( bits, pos );
+        if ( run == FIVE_IN_A_ROW ) {
+            return GAME_STATE_FINISHED;
+        }
+        overline |= run > FIVE_IN_A_ROW;
+    }
+    if ( overline ) {
+        return GAME_STATE_FORBIDDEN;
+    }
+    unsigned char patterns[NUM_AXES];
+    unsigned char fours = 0;
+    unsigned char open_threes = 0;
+    classify_lines( b->grid, center, stride, BLACK_STONE, true, patterns );
+    for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+        if ( patterns[axis] == PATTERN_DOUBLE_FOUR ) {
+            fours += 2;
+        } else if ( patterns[axis] == PATTERN_FOUR || patterns[axis] == PATTERN_OPEN_FOUR ) {
+            fours++;
+        } else if ( patterns[axis] == PATTERN_OPEN_THREE ) {
+            open_threes++;
+        }
+    }
+    if ( fours > MAX_FOURS ) {
+        return GAME_STATE_FORBIDDEN;
+    } else if ( open_threes > MAX_OPEN_THREES && double_three( b, center, stride ) ) {
+        return GAME_STATE_FORBIDDEN;
+    }
+    return GAME_STATE_PLAYING;
+}
+
+/**
+ * Checks a freestyle move, on the line bitboards whatever the size, so every size shares it.
+ */
+static unsigned char check_freestyle( const game* g, unsigned char x, unsigned char y )
+{
+    return check_five( g->board, x, y, g->stone );
+}
+
+/**
+ * Defines the kernels of one board size that walk the grid, named after it, with the stride as a constant.
+ */
+#define DEFINE_KERNELS( size ) \
+    static unsigned char check_renju_##size( const game* g, unsigned char x, unsigned char y ) \
+    { \
+        return check_renju( g->board, x, y, CENTER( STRIDE( size ), x, y ), STRIDE( size ), g->stone ); \
+    } \
+    static void classify_##size( const board* b, unsigned char x, unsigned char y, unsigned char stone, bool exact, unsigned char* patterns ) \
+    { \
+        classify_lines( b->grid, CENTER( STRIDE( size ), x, y ), STRIDE( size ), stone, exact, patterns ); \
+    } \
+    static const rule_kernels freestyle_##size = { size, GAME_FREESTYLE, check_freestyle, classify_##size }; \
+    static const rule_kernels renju_##size = { size, GAME_RENJU, check_renju_##size, classify_##size };
+
+DEFINE_KERNELS( 15 )
+DEFINE_KERNELS( 17 )
+DEFINE_KERNELS( 19 )
+
+/**
+ * Kernels of the other sizes, reading the stride from the board.
+ */
+static unsigned char check_renju_any( const game* g, unsigned char x, unsigned char y )
+{
+    const board* b = g->board;
+    return check_renju( b, x, y, BOARD_INDEX( b, x, y ), b->stride, g->stone );
+}
+
+static void classify_any( const board* b, unsigned char x, unsigned char y, unsigned char stone, bool exact, unsigned char* patterns )
+{
+    classify_lines( b->grid, BOARD_INDEX( b, x, y ), b->stride, stone, exact, patterns );
+}
+
+static const rule_kernels freestyle_any = { 0, GAME_FREESTYLE, check_freestyle, classify_any };
+static const rule_kernels renju_any = { 0, GAME_RENJU, check_renju_any, classify_any };
+
+static const rule_kernels* const specialised[] = {
+    &freestyle_15, &renju_15, &freestyle_17, &renju_17, &freestyle_19, &renju_19
+};
+
+const rule_kernels* rules_select( unsigned char size, unsigned char type )
+{
+    for ( size_t i = 0; i < sizeof( specialised ) / sizeof( specialised[0] ); i++ ) {
+        if ( specialised[i]->size == size && specialised[i]->type == type ) {
+            return specialised[i];
+        }
+    }
+    return type == GAME_RENJU ? &renju_any : &freestyle_any;
+}
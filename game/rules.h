@@ -0,0 +1,37 @@
+#ifndef _RULES_H_
+#define _RULES_H_
+#include "game.h"
+#include "board.h"
+#include <stdbool.h>
+
+/**
+ * The rule kernels of one board size and game type. The kernels that walk the grid, line classification
+ * and the renju forbidden move checks, get copies compiled with a constant stride for the common sizes
+ * (15, 17 and 19), so every step along an axis is an immediate offset and the loops over the axes and the
+ * pattern windows are unrolled. Other sizes share kernels that read the stride from the board. size is 0
+ * for those. Fives and overlines are found on the line bitboards of the board with board_run_length, so
+ * the freestyle move check is the same for every size.
+ */
+struct rule_kernels {
+    unsigned char size;
+    unsigned char type;
+
+    /**
+     * Determines how placing a stone of the current color would end the game, like game_check_move.
+     */
+    unsigned char (*check_move)( const game* g, unsigned char x, unsigned char y );
+
+    /**
+     * Classifies the lines along all four axes through an intersection, like pattern_classify.
+     */
+    void (*classify)( const board* b, unsigned char x, unsigned char y, unsigned char stone, bool exact, unsigned char* patterns );
+};
+
+/**
+ * Picks the kernels for a board size and game type, specialised ones when they exist.
+ * @param size The board size.
+ * @param type The game type (GAME_FREESTYLE or GAME_RENJU).
+ * @return The kernels, valid for the life of the program.
+ */
+const rule_kernels* rules_select(unsigned char size, unsigned char type);
+#endif
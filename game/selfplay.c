@@ -0,0 +1,356 @@
+#define _POSIX_C_SOURCE 200809L
+#include "game.h"
+#include "board.h"
+#include "io.h"
+#include "engine.h"
+#include "error-codes.h"
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#define MAX_THREADS 256
+#define MAX_PATH 4096
+#define PLAYER_RANDOM 0
+#define PLAYER_SEARCH 1
+#define HEURISTIC_DEPTH 1
+#define DEFAULT_GAMES 100
+#define DEFAULT_OPENING 4
+#define DEFAULT_HASH_MB 4
+#define OPENING_RADIUS 3
+#define Z_95 1.959964
+
+/**
+ * One side of the match: plays random moves, or searches to a fixed depth.
+ */
+typedef struct {
+    unsigned char kind;
+    unsigned char depth;
+    const char* name;
+} player;
+
+/**
+ * The match shared by the worker threads. next is the first game no thread has taken yet, and
+ * winners holds the color that won each game (EMPTY_INTERSECTION for a draw).
+ */
+typedef struct {
+    player players[2];
+    unsigned char type;
+    unsigned char size;
+    int games;
+    int opening;
+    uint64_t seed;
+    int hash_mb;
+    const char* directory;
+    int next;
+    unsigned char* winners;
+    unsigned long* nodes;
+} match;
+
+/**
+ * Prints out the error message to the console if command line args are not correct.
+ */
+static void arg_error();
+
+/**
+ * Reads a player description: random, heuristic, or search:<depth>.
+ * @param text The description.
+ * @param p Reference to the location where the player is stored.
+ */
+static void parse_player( const char* text, player* p );
+
+/**
+ * Returns the next number of a splitmix64 sequence.
+ * @param state The state of the sequence, advanced by one step.
+ * @return A pseudo-random 64-bit number.
+ */
+static uint64_t next_random( uint64_t* state );
+
+/**
+ * Plays a uniformly random empty intersection, skipping forbidden ones when there is another choice.
+ * @param g The game.
+ * @param rng The random number state of the game.
+ * @param radius How far from the center the move may be, or 0 for anywhere. The whole board is used
+ * when no allowed move is that close.
+ * @return True if a move was made.
+ */
+static bool play_random( game* g, uint64_t* rng, int radius );
+
+/**
+ * Takes games from the match until none is left and plays them.
+ * @param arg The shared match.
+ * @return NULL.
+ */
+static void* worker( void* arg );
+
+/**
+ * Converts a score between 0 and 1 to an Elo difference.
+ * @param score The expected score, strictly between 0 and 1.
+ * @return The Elo difference.
+ */
+static double elo( double score );
+
+/**
+ * Plays a match between two players and reports the wins, losses and draws of the first with the Elo
+ * difference and its 95% confidence interval. Games are spread over a pool of threads. Each pair of
+ * games starts from the same random opening, with the players swapping colors, and every game is
+ * reproducible from the seed and its number.
+ * Use -games followed by a number to set the number of games (100 by default).
+ * Use -threads followed by a number to set the number of threads (one per core by default).
+ * Use -type followed by gomoku or renju, and -b followed by a size from 15 to 64 to set the game played.
+ * Use -opening followed by a number of random moves to play before the players take over (4 by default).
+ * Use -seed followed by a number to change the random openings.
+ * Use -hash followed by a number of megabytes to size the transposition table of each searching player.
+ * Use -o followed by a directory to save every game there as a .gmk file.
+ * Players are random, heuristic (a one move search) or search:<depth>.
+ * @param argc The total number of arguments.
+ * @param argv[] Array of arguments
+ * return 0 if successful.
+ */
+int main( int argc, char *argv[] ) {
+    match m;
+    m.type = GAME_FREESTYLE;
+    m.size = 15;
+    m.games = DEFAULT_GAMES;
+    m.opening = DEFAULT_OPENING;
+    m.seed = 1;
+    m.hash_mb = DEFAULT_HASH_MB;
+    m.directory = NULL;
+    m.next = 0;
+    long threads = sysconf( _SC_NPROCESSORS_ONLN );
+
+    int i = 1;
+    for ( ; i + 1 < argc && argv[i][0] == '-'; i += 2 ) {
+        if ( strcmp( argv[i], "-games" ) == 0 ) {
+            m.games = atoi( argv[i + 1] );
+        } else if ( strcmp( argv[i], "-threads" ) == 0 ) {
+            threads = atoi( argv[i + 1] );
+            if ( threads <= 0 || threads > MAX_THREADS ) {
+                arg_error();
+            }
+        } else if ( strcmp( argv[i], "-type" ) == 0 && strcmp( argv[i + 1], "gomoku" ) == 0 ) {
+            m.type = GAME_FREESTYLE;
+        } else if ( strcmp( argv[i], "-type" ) == 0 && strcmp( argv[i + 1], "renju" ) == 0 ) {
+            m.type = GAME_RENJU;
+        } else if ( strcmp( argv[i], "-b" ) == 0 ) {
+            m.size = atoi( argv[i + 1] );
+            if ( atoi( argv[i + 1] ) > BOARD_MAX_SIZE || !board_size_valid( m.size ) ) {
+                arg_error();
+            }
+        } else if ( strcmp( argv[i], "-opening" ) == 0 ) {
+            m.opening = atoi( argv[i + 1] );
+        } else if ( strcmp( argv[i], "-seed" ) == 0 ) {
+            m.seed = strtoull( argv[i + 1], NULL, 10 );
+        } else if ( strcmp( argv[i], "-hash" ) == 0 ) {
+            m.hash_mb = atoi( argv[i + 1] );
+        } else if ( strcmp( argv[i], "-o" ) == 0 ) {
+            m.directory = argv[i + 1];
+        } else {
+            arg_error();
+        }
+    }
+    if ( i + 2 != argc || m.games <= 0 || m.opening < 0 || m.hash_mb < 0 ) {
+        arg_error();
+    }
+    parse_player( argv[i], &m.players[0] );
+    parse_player( argv[i + 1], &m.players[1] );
+    if ( threads < 1 ) {
+        threads = 1;
+    } else if ( threads > m.games ) {
+        threads = m.games;
+    }
+
+    m.winners = ( unsigned char * )calloc( m.games, sizeof( unsigned char ) );
+    m.nodes = ( unsigned long * )calloc( m.games, sizeof( unsigned long ) );
+    if (m.winners == NULL || m.nodes == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+
+    struct timespec start;
+    struct timespec end;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    pthread_t pool[MAX_THREADS];
+    for ( int t = 0; t < threads; t++ ) {
+        if ( pthread_create( &pool[t], NULL, worker, &m ) != 0 ) {
+            fprintf(stderr, "ERROR: Failed to start thread\n");
+            exit(1);
+        }
+    }
+    for ( int t = 0; t < threads; t++ ) {
+        pthread_join( pool[t], NULL );
+    }
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    double seconds = ( end.tv_sec - start.tv_sec ) + ( end.tv_nsec - start.tv_nsec ) / 1e9;
+
+    //Count from the point of view of the first player, who is black in even games
+    int wins = 0;
+    int losses = 0;
+    int draws = 0;
+    unsigned long nodes = 0;
+    for ( int g = 0; g < m.games; g++ ) {
+        unsigned char first = g % 2 == 0 ? BLACK_STONE : WHITE_STONE;
+        if ( m.winners[g] == EMPTY_INTERSECTION ) {
+            draws++;
+        } else if ( m.winners[g] == first ) {
+            wins++;
+        } else {
+            losses++;
+        }
+        nodes += m.nodes[g];
+    }
+
+    //Elo difference with a 95% interval from the variance of the game scores
+    double n = m.games;
+    double score = ( wins + 0.5 * draws ) / n;
+    double variance = ( wins * ( 1 - score ) * ( 1 - score ) + draws * ( 0.5 - score ) * ( 0.5 - score ) +
+                        losses * score * score ) / n;
+    double margin = Z_95 * sqrt( variance / n );
+    printf( "%s vs %s: %d games, +%d -%d =%d, score %.1f%%\n", m.players[0].name, m.players[1].name,
+            m.games, wins, losses, draws, 100 * score );
+    if ( wins == m.games || losses == m.games ) {
+        //No finite rating explains a clean sweep
+        printf( "Elo difference: unbounded, %s won every game\n", m.players[wins == m.games ? 0 : 1].name );
+    } else {
+        //The interval stops half a game short of a clean sweep either way
+        double low = score - margin > 0.5 / n ? score - margin : 0.5 / n;
+        double high = score + margin < 1 - 0.5 / n ? score + margin : 1 - 0.5 / n;
+        printf( "Elo difference: %.1f (95%% interval %.1f to %.1f)\n", elo( score ), elo( low ), elo( high ) );
+    }
+    printf( "%.3f s, %.0f games/min, %.0f nodes/s with %ld threads\n", seconds, seconds > 0 ? 60 * n / seconds : 0.0,
+            seconds > 0 ? nodes / seconds : 0.0, threads );
+
+    free( m.winners );
+    free( m.nodes );
+    return 0;
+}
+
+static void arg_error() {
+    printf( "usage: ./selfplay [-games <count>] [-threads <count>] [-type <gomoku|renju>] [-b <15-64>] [-opening <moves>]\n"
+            "                  [-seed <number>] [-hash <megabytes>] [-o <directory>] <player> <player>\n"
+            "       players are random, heuristic or search:<depth>\n" );
+    exit( ARGUMENT_ERR );
+}
+
+static void parse_player( const char* text, player* p )
+{
+    p->name = text;
+    if ( strcmp( text, "random" ) == 0 ) {
+        p->kind = PLAYER_RANDOM;
+        p->depth = 0;
+    } else if ( strcmp( text, "heuristic" ) == 0 ) {
+        p->kind = PLAYER_SEARCH;
+        p->depth = HEURISTIC_DEPTH;
+    } else if ( strncmp( text, "search:", 7 ) == 0 && atoi( text + 7 ) > 0 && atoi( text + 7 ) <= ENGINE_MAX_DEPTH ) {
+        p->kind = PLAYER_SEARCH;
+        p->depth = atoi( text + 7 );
+    } else {
+        arg_error();
+    }
+}
+
+static uint64_t next_random( uint64_t* state )
+{
+    uint64_t z = ( *state += 0x9E3779B97F4A7C15ULL );
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+}
+
+static bool play_random( game* g, uint64_t* rng, int radius )
+{
+    board* b = g->board;
+    unsigned short count = board_empty_count( b );
+    if ( count == 0 ) {
+        return false;
+    }
+    //Walk the empty set from a random place and take the first allowed intersection
+    unsigned short first = next_random( rng ) % count;
+    unsigned char x;
+    unsigned char y;
+    bool found = false;
+    for ( unsigned short i = 0; i < count && !found; i++ ) {
+        board_empty_point( b, ( first + i ) % count, &x, &y );
+        found = ( radius == 0 || ( abs( x - b->size / 2 ) <= radius && abs( y - b->size / 2 ) <= radius ) ) &&
+                game_check_move( g, x, y ) != GAME_STATE_FORBIDDEN;
+    }
+    if ( !found && radius != 0 ) {
+        //Nothing allowed near the center, look at the whole board
+        return play_random( g, rng, 0 );
+    } else if ( !found ) {
+        //Every empty intersection is forbidden, so the move loses whichever it is
+        board_empty_point( b, first, &x, &y );
+    }
+    return game_make_move( g, x, y );
+}
+
+static void* worker( void* arg )
+{
+    match* m = ( match * )arg;
+    tt* tables[2] = { NULL, NULL };
+    for ( int p = 0; p < 2; p++ ) {
+        if ( m->players[p].kind == PLAYER_SEARCH && m->hash_mb > 0 ) {
+            tables[p] = tt_create( m->hash_mb );
+        }
+    }
+
+    int number;
+    while ( ( number = __atomic_fetch_add( &m->next, 1, __ATOMIC_RELAXED ) ) < m->games ) {
+        //Both games of a pair share the opening; the first player is black in the even one
+        uint64_t rng = m->seed * 0x100000001B3ULL + number / 2;
+        game* g = game_create( m->size, m->type );
+        for ( int i = 0; i < m->opening && g->state == GAME_STATE_PLAYING; i++ ) {
+            play_random( g, &rng, OPENING_RADIUS );
+        }
+        rng ^= number;
+        for ( int p = 0; p < 2; p++ ) {
+            if ( tables[p] != NULL ) {
+                tt_clear( tables[p] );
+            }
+        }
+
+        unsigned long nodes = 0;
+        while ( g->state == GAME_STATE_PLAYING ) {
+            int p = ( g->stone == BLACK_STONE ) == ( number % 2 == 0 ) ? 0 : 1;
+            if ( m->players[p].kind == PLAYER_RANDOM ) {
+                if ( !play_random( g, &rng, 0 ) ) {
+                    break;
+                }
+            } else {
+                engine_limits limits = { m->players[p].depth, 0, tables[p], 1 };
+                engine_result result;
+                if ( !engine_search( g, &limits, &result ) ) {
+                    break;
+                }
+                nodes += result.nodes;
+                game_make_move( g, result.x, result.y );
+            }
+        }
+        //A game left unfinished because no move was found is saved as stopped, so it can be read back
+        if ( g->state == GAME_STATE_PLAYING ) {
+            g->state = GAME_STATE_STOPPED;
+        }
+        m->winners[number] = g->winner;
+        m->nodes[number] = nodes;
+
+        if ( m->directory != NULL ) {
+            char path[MAX_PATH];
+            if ( snprintf( path, MAX_PATH, "%s/game-%06d.gmk", m->directory, number + 1 ) >= MAX_PATH ) {
+                exit( FILE_OUTPUT_ERR );
+            }
+            game_export( g, path );
+        }
+        game_delete( g );
+    }
+
+    for ( int p = 0; p < 2; p++ ) {
+        if ( tables[p] != NULL ) {
+            tt_delete( tables[p] );
+        }
+    }
+    return NULL;
+}
+
+static double elo( double score )
+{
+    return -400 * log10( 1 / score - 1 );
+}
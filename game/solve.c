@@ -0,0 +1,139 @@
+#include "game.h"
+#include "board.h"
+#include "io.h"
+#include "solver.h"
+#include "error-codes.h"
+#include <string.h>
+
+/**
+ * Prints out the error message to the console if command line args are not correct.
+ */
+static void arg_error();
+
+/**
+ * Replays a saved game and reports the forced wins the solver finds. By default only the position after the
+ * last saved move is solved. With all set, every position of the game is solved and only the forced wins
+ * that the player to move did not go on to win are reported.
+ * @param path Path to the saved game.
+ * @param limits The threats to consider and the budget of each solve.
+ * @param all True to solve every position of the game, false for the last one only.
+ */
+static void solve_file( const char* path, const solver_limits* limits, bool all );
+
+/**
+ * Prints a winning line in formal coordinates.
+ * @param g The game the line was found in.
+ * @param result The solver result holding the line.
+ */
+static void print_line( game* g, const solver_result* result );
+
+/**
+ * Counts the moves of the winning side in a solved line. Usually every other move, but a four the
+ * defender cannot legally block is followed by the five directly.
+ * @param result The solved line.
+ * @param stone The color of the winning side.
+ * @return The number of moves the winning side plays.
+ */
+static int attacker_moves( const solver_result* result, unsigned char stone );
+
+/**
+ * Looks for forced wins (VCF, or VCT with -vct) in saved games.
+ * Use -vct to search threes as well as fours.
+ * Use -depth, -nodes and -time followed by a number to limit each solve to that many attacking moves,
+ * search nodes or milliseconds.
+ * Use -all to solve every position of each game and report the forced wins that were missed.
+ * @param argc The total number of arguments.
+ * @param argv[] Array of arguments
+ * return 0 if successful.
+ */
+int main( int argc, char *argv[] ) {
+    solver_limits limits = { SOLVER_VCF, SOLVER_DEFAULT_DEPTH, SOLVER_DEFAULT_NODES, 0 };
+    bool all = false;
+    
+    int i = 1;
+    for ( ; i < argc && argv[i][0] == '-'; i++ ) {
+        if ( strcmp( argv[i], "-vct" ) == 0 ) {
+            limits.mode = SOLVER_VCT;
+        } else if ( strcmp( argv[i], "-all" ) == 0 ) {
+            all = true;
+        } else if ( i + 1 >= argc ) {
+            arg_error();
+        } else if ( strcmp( argv[i], "-depth" ) == 0 ) {
+            limits.max_depth = atoi( argv[++i] );
+        } else if ( strcmp( argv[i], "-nodes" ) == 0 ) {
+            limits.max_nodes = strtoul( argv[++i], NULL, 10 );
+        } else if ( strcmp( argv[i], "-time" ) == 0 ) {
+            limits.time_ms = atoi( argv[++i] );
+        } else {
+            arg_error();
+        }
+    }
+    if ( i == argc ) {
+        arg_error();
+    }
+    
+    for ( ; i < argc; i++ ) {
+        solve_file( argv[i], &limits, all );
+    }
+    return 0;
+}
+
+static void solve_file( const char* path, const solver_limits* limits, bool all )
+{
+    game* saved = game_import( path );
+    game* g = game_create( saved->board->size, saved->type );
+    const char* mode = limits->mode == SOLVER_VCT ? "VCT" : "VCF";
+    int num_moves = saved->moves_count;
+    
+    for ( int ply = 0; ply <= num_moves; ply++ ) {
+        if ( g->state != GAME_STATE_PLAYING ) {
+            if ( !all ) {
+                printf( "%s: the game is over after move %d\n", path, ply );
+            }
+            break;
+        }
+        if ( all || ply == num_moves ) {
+            solver_result result;
+            unsigned char status = solver_solve( g, limits, &result );
+            const char* player = g->stone == BLACK_STONE ? "black" : "white";
+            if ( !all && status == SOLVER_WIN ) {
+                printf( "%s: %s wins by %s in %d moves:", path, player, mode, attacker_moves( &result, g->stone ) );
+                print_line( g, &result );
+            } else if ( !all ) {
+                printf( "%s: %s\n", path, status == SOLVER_NO_WIN ? "no forced win" : "unknown, budget exhausted" );
+            } else if ( status == SOLVER_WIN && saved->winner != g->stone ) {
+                printf( "%s: move %d, %s missed a %s in %d moves:", path, ply + 1, player, mode, attacker_moves( &result, g->stone ) );
+                print_line( g, &result );
+            }
+        }
+        if ( ply < num_moves && !game_make_move( g, saved->moves[ply].x, saved->moves[ply].y ) ) {
+            break;
+        }
+    }
+    game_delete( g );
+    game_delete( saved );
+}
+
+static void print_line( game* g, const solver_result* result )
+{
+    char formal_coord[BOARD_COORD_LENGTH];
+    for ( int i = 0; i < result->length; i++ ) {
+        board_formal_coord( g->board, result->sequence[i].x, result->sequence[i].y, formal_coord );
+        printf( " %s", formal_coord );
+    }
+    printf( "\n" );
+}
+
+static int attacker_moves( const solver_result* result, unsigned char stone )
+{
+    int count = 0;
+    for ( int i = 0; i < result->length; i++ ) {
+        count += result->sequence[i].stone == stone;
+    }
+    return count;
+}
+
+static void arg_error() {
+    printf( "usage: ./solve [-vct] [-all] [-depth <moves>] [-nodes <count>] [-time <ms>] <saved-match.gmk>...\n" );
+    exit( ARGUMENT_ERR );
+}
@@ -0,0 +1,316 @@
+#define _POSIX_C_SOURCE 200809L
+#include "solver.h"
+#include "board.h"
+#include "game.h"
+#include "pattern.h"
+#include "rules.h"
+#include <time.h>
+#define MAX_CELLS ( BOARD_MAX_SIZE * BOARD_MAX_SIZE )
+#define THREAT_REACH 4
+#define TIME_CHECK_NODES 1024
+
+/**
+ * An empty intersection and the strongest pattern a stone there would make.
+ */
+typedef struct {
+    unsigned char x;
+    unsigned char y;
+    unsigned char pattern;
+} threat;
+
+/**
+ * State of one running solve. pv[ply] holds the winning line found below that ply.
+ */
+typedef struct {
+    game* g;
+    solver_limits limits;
+    struct timespec start;
+    unsigned long nodes;
+    bool aborted;
+    unsigned char attacker;
+    move pv[SOLVER_MAX_PLY][SOLVER_MAX_PLY];
+    unsigned char pv_length[SOLVER_MAX_PLY];
+} solver;
+
+/**
+ * Finds the empty intersections where a stone of the given color would make at least the given pattern,
+ * strongest first. Only intersections within THREAT_REACH of a stone of that color are checked.
+ * @param s The running solve.
+ * @param stone The color to check.
+ * @param min_pattern The weakest pattern to keep.
+ * @param threats Array of at least MAX_CELLS where the threats are stored.
+ * @return The number of threats stored.
+ */
+static int find_threats( solver* s, unsigned char stone, unsigned char min_pattern, threat* threats );
+
+/**
+ * Searches the attacker's threats with the attacker to move.
+ * @param s The running solve.
+ * @param depth The number of attacking moves left.
+ * @param ply The distance from the root in moves.
+ * @return True if the attacker has a forced win within the depth.
+ */
+static bool attack( solver* s, int depth, int ply );
+
+/**
+ * Searches every defence against the attacker's last threat with the defender to move.
+ * @param s The running solve.
+ * @param depth The number of attacking moves left.
+ * @param ply The distance from the root in moves.
+ * @param last The attacker's last move.
+ * @return True if the attacker still wins against every defence.
+ */
+static bool defend( solver* s, int depth, int ply, const move* last );
+
+/**
+ * Stores a move followed by the line found one ply deeper as the line of this ply.
+ * @param s The running solve.
+ * @param ply The ply of the move.
+ * @param x The horizontal coordinate of the move.
+ * @param y The vertical coordinate of the move.
+ * @param stone The color of the move.
+ */
+static void save_line( solver* s, int ply, unsigned char x, unsigned char y, unsigned char stone );
+
+/**
+ * Counts the node and checks the node and time budget.
+ * @param s The running solve.
+ * @return True if the search must stop.
+ */
+static bool out_of_budget( solver* s );
+
+unsigned char solver_solve( game* g, const solver_limits* limits, solver_result* result )
+{
+    //Large enough to keep on the heap
+    solver* s = ( solver * )malloc( sizeof( solver ) );
+    if (s == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    s->g = g;
+    s->limits = *limits;
+    s->nodes = 0;
+    s->aborted = false;
+    s->attacker = g->stone;
+    clock_gettime( CLOCK_MONOTONIC, &s->start );
+    
+    result->status = SOLVER_NO_WIN;
+    result->length = 0;
+    if ( g->state == GAME_STATE_PLAYING ) {
+        unsigned char max_depth = limits->max_depth ? limits->max_depth : SOLVER_DEFAULT_DEPTH;
+        if ( max_depth > SOLVER_MAX_DEPTH ) {
+            max_depth = SOLVER_MAX_DEPTH;
+        }
+        //Deepen one attacking move at a time so the shortest win is found first
+        for ( int depth = 1; depth <= max_depth; depth++ ) {
+            if ( attack( s, depth, 0 ) ) {
+                result->status = SOLVER_WIN;
+                result->length = s->pv_length[0];
+                memcpy( result->sequence, s->pv[0], s->pv_length[0] * sizeof( move ) );
+                break;
+            } else if ( s->aborted ) {
+                result->status = SOLVER_UNKNOWN;
+                break;
+            }
+        }
+    }
+    result->nodes = s->nodes;
+    free( s );
+    return result->status;
+}
+
+static bool out_of_budget( solver* s )
+{
+    s->nodes++;
+    if ( s->limits.max_nodes && s->nodes > s->limits.max_nodes ) {
+        s->aborted = true;
+    } else if ( s->limits.time_ms && s->nodes % TIME_CHECK_NODES == 0 ) {
+        struct timespec now;
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        unsigned int elapsed = ( now.tv_sec - s->start.tv_sec ) * 1000 + ( now.tv_nsec - s->start.tv_nsec ) / 1000000;
+        s->aborted = elapsed >= s->limits.time_ms;
+    }
+    return s->aborted;
+}
+
+static void save_line( solver* s, int ply, unsigned char x, unsigned char y, unsigned char stone )
+{
+    move mv = { x, y, stone };
+    s->pv[ply][0] = mv;
+    unsigned char length = 1;
+    if ( ply + 1 < SOLVER_MAX_PLY ) {
+        memcpy( &s->pv[ply][1], s->pv[ply + 1], s->pv_length[ply + 1] * sizeof( move ) );
+        length += s->pv_length[ply + 1];
+    }
+    s->pv_length[ply] = length;
+}
+
+static int find_threats( solver* s, unsigned char stone, unsigned char min_pattern, threat* threats )
+{
+    board* b = s->g->board;
+    bool exact = s->g->type == GAME_RENJU && stone == BLACK_STONE;
+    
+    //Only intersections near a stone of this color can make a threat with it
+    line_bits own[BOARD_MAX_SIZE];
+    line_bits occupied[BOARD_MAX_SIZE];
+    for ( int y = 0; y < b->size; y++ ) {
+        own[y] = board_line( b, stone, AXIS_HORIZONTAL, 0, y, NULL );
+        occupied[y] = own[y] | board_line( b, stone == BLACK_STONE ? WHITE_STONE : BLACK_STONE, AXIS_HORIZONTAL, 0, y, NULL );
+    }
+    line_bits row_mask = board_line_mask( b, AXIS_HORIZONTAL, 0, 0 );
+    bounds box;
+    if ( !board_bounds( b, THREAT_REACH, &box ) ) {
+        return 0;
+    }
+    
+    int count = 0;
+    for ( int y = box.min_y; y <= box.max_y; y++ ) {
+        line_bits near = 0;
+        for ( int row = y - THREAT_REACH; row <= y + THREAT_REACH; row++ ) {
+            if ( row >= 0 && row < b->size ) {
+                for ( int shift = 0; shift <= THREAT_REACH; shift++ ) {
+                    near |= own[row] << shift | own[row] >> shift;
+                }
+            }
+        }
+        near &= row_mask & ~occupied[y];
+        
+        while ( near ) {
+            unsigned char x = LINE_CTZ( near );
+            near &= near - 1;
+            
+            //Overlines only appear with exact five rules, where they are forbidden
+            unsigned char patterns[NUM_AXES];
+            unsigned char best = PATTERN_NONE;
+            s->g->kernels->classify( b, x, y, stone, exact, patterns );
+            for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+                if ( patterns[axis] != PATTERN_OVERLINE && patterns[axis] > best ) {
+                    best = patterns[axis];
+                }
+            }
+            if ( best < min_pattern ) {
+                continue;
+            }
+            //Insert in descending pattern order
+            int i = count++;
+            while ( i > 0 && threats[i - 1].pattern < best ) {
+                threats[i] = threats[i - 1];
+                i--;
+            }
+            threats[i].x = x;
+            threats[i].y = y;
+            threats[i].pattern = best;
+        }
+    }
+    return count;
+}
+
+static bool attack( solver* s, int depth, int ply )
+{
+    game* g = s->g;
+    unsigned char defender = g->stone == BLACK_STONE ? WHITE_STONE : BLACK_STONE;
+    if ( out_of_budget( s ) ) {
+        return false;
+    }
+    
+    //Win at once with a five
+    threat threats[MAX_CELLS];
+    int count = find_threats( s, g->stone, s->limits.mode == SOLVER_VCT ? PATTERN_OPEN_THREE : PATTERN_FOUR, threats );
+    if ( count > 0 && threats[0].pattern == PATTERN_FIVE ) {
+        //The five ends the line, and ply may be the last one there is room for
+        move five = { threats[0].x, threats[0].y, g->stone };
+        s->pv[ply][0] = five;
+        s->pv_length[ply] = 1;
+        return true;
+    }
+    if ( depth <= 0 || ply + 2 >= SOLVER_MAX_PLY ) {
+        return false;
+    }
+    
+    //If the defender threatens a five, the next threat has to block it
+    threat fives[MAX_CELLS];
+    int num_fives = find_threats( s, defender, PATTERN_FIVE, fives );
+    
+    for ( int i = 0; i < count && !s->aborted; i++ ) {
+        if ( num_fives > 1 || ( num_fives == 1 && ( fives[0].x != threats[i].x || fives[0].y != threats[i].y ) ) ) {
+            continue;
+        }
+        if ( game_check_move( g, threats[i].x, threats[i].y ) == GAME_STATE_FORBIDDEN ) {
+            continue;
+        }
+        move last = { threats[i].x, threats[i].y, g->stone };
+        game_make_move( g, last.x, last.y );
+        bool won = defend( s, depth - 1, ply + 1, &last );
+        game_unmake_move( g );
+        if ( won ) {
+            save_line( s, ply, last.x, last.y, last.stone );
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool defend( solver* s, int depth, int ply, const move* last )
+{
+    game* g = s->g;
+    board* b = g->board;
+    if ( out_of_budget( s ) ) {
+        return false;
+    }
+    
+    //The defender wins first with a five of their own
+    threat defences[MAX_CELLS];
+    if ( find_threats( s, g->stone, PATTERN_FIVE, defences ) > 0 ) {
+        return false;
+    }
+    
+    //Against a four the only defence is the blocking point, and two of them cannot both be blocked
+    int count = find_threats( s, s->attacker, PATTERN_FIVE, defences );
+    bool four = count > 0;
+    if ( !four ) {
+        //Against a three, block on the lines through the attacking move or counter with a four
+        count = find_threats( s, g->stone, PATTERN_FOUR, defences );
+        for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+            for ( int distance = -THREAT_REACH; distance <= THREAT_REACH; distance++ ) {
+                int cell = BOARD_INDEX( b, last->x, last->y ) + distance * b->step[axis];
+                if ( distance == 0 || b->grid[cell] != EMPTY_INTERSECTION ) {
+                    continue;
+                }
+                //Recover the coordinates from the padded index
+                defences[count].x = cell % b->stride - BOARD_PADDING;
+                defences[count].y = cell / b->stride - BOARD_PADDING;
+                defences[count].pattern = PATTERN_NONE;
+                count++;
+            }
+        }
+    }
+    
+    bool defended = false;
+    for ( int i = 0; i < count && !s->aborted; i++ ) {
+        //Forbidden moves cannot be used to defend
+        if ( game_check_move( g, defences[i].x, defences[i].y ) == GAME_STATE_FORBIDDEN ) {
+            continue;
+        }
+        move mv = { defences[i].x, defences[i].y, g->stone };
+        if ( !game_make_move( g, mv.x, mv.y ) ) {
+            continue;
+        }
+        bool won = attack( s, depth, ply + 1 );
+        game_unmake_move( g );
+        if ( !won ) {
+            return false;
+        }
+        defended = true;
+        save_line( s, ply, mv.x, mv.y, mv.stone );
+    }
+    if ( s->aborted ) {
+        return false;
+    } else if ( !defended && four ) {
+        //A four that cannot legally be blocked is completed on the next move, with no defender move before it
+        move five = { defences[0].x, defences[0].y, s->attacker };
+        s->pv[ply][0] = five;
+        s->pv_length[ply] = 1;
+        return true;
+    }
+    return defended;
+}
@@ -0,0 +1,48 @@
+#ifndef _SOLVER_H_
+#define _SOLVER_H_
+#include "game.h"
+#include <stdbool.h>
+#define SOLVER_VCF 0
+#define SOLVER_VCT 1
+#define SOLVER_NO_WIN 0
+#define SOLVER_WIN 1
+#define SOLVER_UNKNOWN 2
+#define SOLVER_MAX_DEPTH 32
+#define SOLVER_MAX_PLY ( 2 * SOLVER_MAX_DEPTH + 1 )
+#define SOLVER_DEFAULT_DEPTH 16
+#define SOLVER_DEFAULT_NODES 1000000
+
+/**
+ * Which threats to search and how much work to spend. A zero max_nodes or time_ms means no limit of that kind.
+ */
+typedef struct {
+    unsigned char mode;
+    unsigned char max_depth;
+    unsigned long max_nodes;
+    unsigned int time_ms;
+} solver_limits;
+
+/**
+ * The outcome of a threat-space search. When the side to move has a forced win, sequence holds one line of it,
+ * attacker and defender moves alternating and ending with the five. The one exception is a four the defender
+ * cannot block because the blocking point is forbidden for black in renju: the five then follows the four directly.
+ */
+typedef struct {
+    unsigned char status;
+    unsigned char length;
+    move sequence[SOLVER_MAX_PLY];
+    unsigned long nodes;
+} solver_result;
+
+/**
+ * Looks for a forced win for the side to move that only uses threats: continuous fours (SOLVER_VCF), or fours and
+ * open threes (SOLVER_VCT). Defences to a four are limited to the blocking point, defences to a three to the
+ * intersections near it and counter fours. The search deepens one attacking move at a time, so the first win
+ * found is the shortest. Moves are made and unmade on the given game and nothing is printed.
+ * @param g The game to solve. Must be in the GAME_STATE_PLAYING state.
+ * @param limits The threats to consider and the node, depth and time budget.
+ * @param result Reference to the location where the outcome and winning line are stored.
+ * @return SOLVER_WIN, SOLVER_NO_WIN, or SOLVER_UNKNOWN if the budget ran out first.
+ */
+unsigned char solver_solve(game* g, const solver_limits* limits, solver_result* result);
+#endif
@@ -0,0 +1,270 @@
+#include "threat.h"
+#include "pattern.h"
+#include <pthread.h>
+#include <string.h>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define THREAT_X86
+#include <immintrin.h>
+#endif
+#define MAX_LANES 16
+
+/**
+ * Computes the pattern keys of both colors along the four axes of a run of intersections on one row.
+ * Key k of lane i describes intersection (x + i, y), like pattern_key. The run must end on the board.
+ */
+typedef void (*key_kernel)( const board* b, unsigned char x, unsigned char y, unsigned short keys[2][NUM_AXES][MAX_LANES] );
+
+/**
+ * Computes the keys of a single intersection with scalar code.
+ * @param b Reference to the current board.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param keys The keys, stored in lane 0.
+ */
+static void keys_scalar( const board* b, unsigned char x, unsigned char y, unsigned short keys[2][NUM_AXES][MAX_LANES] );
+
+#ifdef THREAT_X86
+/**
+ * Computes the keys of 8 intersections at once with SSE2.
+ * @param b Reference to the current board.
+ * @param x The horizontal coordinate of the first intersection.
+ * @param y The vertical coordinate of the intersections.
+ * @param keys The keys, stored in lanes 0 to 7.
+ */
+static void keys_sse2( const board* b, unsigned char x, unsigned char y, unsigned short keys[2][NUM_AXES][MAX_LANES] );
+
+/**
+ * Computes the keys of 16 intersections at once with AVX2.
+ * @param b Reference to the current board.
+ * @param x The horizontal coordinate of the first intersection.
+ * @param y The vertical coordinate of the intersections.
+ * @param keys The keys, stored in lanes 0 to 15.
+ */
+static void keys_avx2( const board* b, unsigned char x, unsigned char y, unsigned short keys[2][NUM_AXES][MAX_LANES] );
+#endif
+
+/**
+ * Looks up the keys of a run of intersections and stores the strongest pattern of each color in the map.
+ * @param b Reference to the current board.
+ * @param x The horizontal coordinate of the first intersection.
+ * @param y The vertical coordinate of the intersections.
+ * @param count The number of intersections.
+ * @param exact True if black only makes a five with exactly five stones.
+ * @param keys The keys returned by a kernel.
+ * @param map Reference to the map being filled.
+ */
+static void store( const board* b, unsigned char x, unsigned char y, int count, bool exact,
+                   unsigned short keys[2][NUM_AXES][MAX_LANES], threat_map* map );
+
+/**
+ * Picks the fastest kernel the processor supports.
+ * @return One of the THREAT_KERNEL_ constants.
+ */
+static unsigned char best_kernel();
+
+/**
+ * Makes the fastest kernel the active one, run once through pthread_once.
+ */
+static void pick_kernel();
+
+#ifdef THREAT_X86
+static const key_kernel kernels[NUM_THREAT_KERNELS] = { keys_scalar, keys_sse2, keys_avx2 };
+#else
+static const key_kernel kernels[NUM_THREAT_KERNELS] = { keys_scalar, NULL, NULL };
+#endif
+static const int lanes[NUM_THREAT_KERNELS] = { 1, 8, 16 };
+static const char* const names[NUM_THREAT_KERNELS] = { "scalar", "sse2", "avx2" };
+//Read and written with relaxed atomics, so a kernel forced while other threads scan is picked up by their next scan
+static int active = THREAT_KERNEL_SCALAR;
+static pthread_once_t picked = PTHREAD_ONCE_INIT;
+
+void threat_scan( const game* g, threat_map* map )
+{
+    const board* b = g->board;
+    map->size = b->size;
+    memset( map->patterns[0], PATTERN_NONE, b->size * b->size );
+    memset( map->patterns[1], PATTERN_NONE, b->size * b->size );
+    //A window without stones of a color holds no pattern of it
+    bounds box;
+    if ( !board_bounds( b, PATTERN_REACH, &box ) ) {
+        return;
+    }
+    pthread_once( &picked, pick_kernel );
+    //AVX2 runs do not fit on a 15x15 board, SSE2 ones do
+    int chosen = __atomic_load_n( &active, __ATOMIC_RELAXED );
+    while ( lanes[chosen] > b->size ) {
+        chosen--;
+    }
+    const key_kernel kernel = kernels[chosen];
+    const int width = lanes[chosen];
+    const bool exact = g->type == GAME_RENJU;
+    unsigned short keys[2][NUM_AXES][MAX_LANES];
+    for ( int y = box.min_y; y <= box.max_y; y++ ) {
+        int x = box.min_x;
+        for ( ; x + width <= box.max_x + 1; x += width ) {
+            kernel( b, x, y, keys );
+            store( b, x, y, width, exact, keys, map );
+        }
+        if ( x > box.max_x ) {
+            continue;
+        }
+        //Finish the row with one run ending on the last column when it fits on the board,
+        //redoing a few intersections, or one intersection at a time
+        if ( b->size >= width ) {
+            x = x < b->size - width ? x : b->size - width;
+            kernel( b, x, y, keys );
+            store( b, x, y, width, exact, keys, map );
+        } else {
+            for ( ; x <= box.max_x; x++ ) {
+                keys_scalar( b, x, y, keys );
+                store( b, x, y, 1, exact, keys, map );
+            }
+        }
+    }
+}
+
+unsigned char threat_at( const threat_map* map, unsigned char x, unsigned char y, unsigned char stone )
+{
+    return map->patterns[stone - 1][y * map->size + x];
+}
+
+bool threat_kernel_supported( unsigned char kernel )
+{
+#ifdef THREAT_X86
+    __builtin_cpu_init();
+    if ( kernel == THREAT_KERNEL_AVX2 ) {
+        return __builtin_cpu_supports( "avx2" );
+    } else if ( kernel == THREAT_KERNEL_SSE2 ) {
+        return __builtin_cpu_supports( "sse2" );
+    }
+#endif
+    return kernel == THREAT_KERNEL_SCALAR;
+}
+
+bool threat_use_kernel( unsigned char kernel )
+{
+    if ( kernel >= NUM_THREAT_KERNELS || !threat_kernel_supported( kernel ) ) {
+        return false;
+    }
+    //Pick the default first, so that it cannot replace the forced kernel later
+    pthread_once( &picked, pick_kernel );
+    __atomic_store_n( &active, kernel, __ATOMIC_RELAXED );
+    return true;
+}
+
+const char* threat_kernel_name( unsigned char kernel )
+{
+    return kernel < NUM_THREAT_KERNELS ? names[kernel] : "unknown";
+}
+
+static void keys_scalar( const board* b, unsigned char x, unsigned char y, unsigned short keys[2][NUM_AXES][MAX_LANES] )
+{
+    for ( unsigned char axis = 0; axis < NUM_AXES; axis++ ) {
+        keys[0][axis][0] = pattern_key( b, x, y, BLACK_STONE, axis );
+        keys[1][axis][0] = pattern_key( b, x, y, WHITE_STONE, axis );
+    }
+}
+
+#ifdef THREAT_X86
+//Both kernels build the keys like pattern_key, by Horner's rule from the far end of the window, with one
+//16-bit lane per intersection. The digit of a cell is 0 when empty, 2 when blocked and 1 for an own stone,
+//which is 2 plus the all-ones (-1) mask of the compare with the own color.
+__attribute__((target("sse2")))
+static void keys_sse2( const board* b, unsigned char x, unsigned char y, unsigned short keys[2][NUM_AXES][MAX_LANES] )
+{
+    const unsigned char* first = b->grid + BOARD_INDEX( b, x, y );
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i black = _mm_set1_epi16( BLACK_STONE );
+    const __m128i white = _mm_set1_epi16( WHITE_STONE );
+    const __m128i blocked = _mm_set1_epi16( 2 );
+    for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+        const int step = b->step[axis];
+        __m128i black_key = zero;
+        __m128i white_key = zero;
+        for ( int i = PATTERN_REACH; i >= -PATTERN_REACH; i-- ) {
+            if ( i == 0 ) {
+                continue;
+            }
+            __m128i cells = _mm_unpacklo_epi8( _mm_loadl_epi64( ( const __m128i* )( first + i * step ) ), zero );
+            __m128i taken = _mm_andnot_si128( _mm_cmpeq_epi16( cells, zero ), blocked );
+            black_key = _mm_add_epi16( _mm_add_epi16( _mm_slli_epi16( black_key, 1 ), black_key ),
+                                       _mm_add_epi16( taken, _mm_cmpeq_epi16( cells, black ) ) );
+            white_key = _mm_add_epi16( _mm_add_epi16( _mm_slli_epi16( white_key, 1 ), white_key ),
+                                       _mm_add_epi16( taken, _mm_cmpeq_epi16( cells, white ) ) );
+        }
+        _mm_storeu_si128( ( __m128i* )keys[0][axis], black_key );
+        _mm_storeu_si128( ( __m128i* )keys[1][axis], white_key );
+    }
+}
+
+__attribute__((target("avx2")))
+static void keys_avx2( const board* b, unsigned char x, unsigned char y, unsigned short keys[2][NUM_AXES][MAX_LANES] )
+{
+    const unsigned char* first = b->grid + BOARD_INDEX( b, x, y );
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i black = _mm256_set1_epi16( BLACK_STONE );
+    const __m256i white = _mm256_set1_epi16( WHITE_STONE );
+    const __m256i blocked = _mm256_set1_epi16( 2 );
+    for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+        const int step = b->step[axis];
+        __m256i black_key = zero;
+        __m256i white_key = zero;
+        for ( int i = PATTERN_REACH; i >= -PATTERN_REACH; i-- ) {
+            if ( i == 0 ) {
+                continue;
+            }
+            __m256i cells = _mm256_cvtepu8_epi16( _mm_loadu_si128( ( const __m128i* )( first + i * step ) ) );
+            __m256i taken = _mm256_andnot_si256( _mm256_cmpeq_epi16( cells, zero ), blocked );
+            black_key = _mm256_add_epi16( _mm256_add_epi16( _mm256_slli_epi16( black_key, 1 ), black_key ),
+                                          _mm256_add_epi16( taken, _mm256_cmpeq_epi16( cells, black ) ) );
+            white_key = _mm256_add_epi16( _mm256_add_epi16( _mm256_slli_epi16( white_key, 1 ), white_key ),
+                                          _mm256_add_epi16( taken, _mm256_cmpeq_epi16( cells, white ) ) );
+        }
+        _mm256_storeu_si256( ( __m256i* )keys[0][axis], black_key );
+        _mm256_storeu_si256( ( __m256i* )keys[1][axis], white_key );
+    }
+}
+#endif
+
+static void store( const board* b, unsigned char x, unsigned char y, int count, bool exact,
+                   unsigned short keys[2][NUM_AXES][MAX_LANES], threat_map* map )
+{
+    const unsigned char* grid = b->grid + BOARD_INDEX( b, x, y );
+    unsigned char* black = map->patterns[0] + BOARD_CELL( b, x, y );
+    unsigned char* white = map->patterns[1] + BOARD_CELL( b, x, y );
+    for ( int i = 0; i < count; i++ ) {
+        if ( grid[i] != EMPTY_INTERSECTION ) {
+            continue;
+        }
+        //Overlines only appear with exact five rules, where they are forbidden
+        unsigned char best_black = PATTERN_NONE;
+        unsigned char best_white = PATTERN_NONE;
+        for ( int axis = 0; axis < NUM_AXES; axis++ ) {
+            unsigned char pattern = pattern_of( keys[0][axis][i], exact );
+            if ( pattern != PATTERN_OVERLINE && pattern > best_black ) {
+                best_black = pattern;
+            }
+            pattern = pattern_of( keys[1][axis][i], false );
+            if ( pattern > best_white ) {
+                best_white = pattern;
+            }
+        }
+        black[i] = best_black;
+        white[i] = best_white;
+    }
+}
+
+static void pick_kernel()
+{
+    __atomic_store_n( &active, best_kernel(), __ATOMIC_RELAXED );
+}
+
+static unsigned char best_kernel()
+{
+    for ( int kernel = NUM_THREAT_KERNELS - 1; kernel > THREAT_KERNEL_SCALAR; kernel-- ) {
+        if ( threat_kernel_supported( kernel ) ) {
+            return kernel;
+        }
+    }
+    return THREAT_KERNEL_SCALAR;
+}
@@ -0,0 +1,64 @@
+#ifndef _THREAT_H_
+#define _THREAT_H_
+#include "game.h"
+#include "board.h"
+#include <stdbool.h>
+#define THREAT_KERNEL_SCALAR 0
+#define THREAT_KERNEL_SSE2 1
+#define THREAT_KERNEL_AVX2 2
+#define NUM_THREAT_KERNELS 3
+
+/**
+ * What a stone of each color would make on every intersection of a board.
+ * patterns[stone - 1][BOARD_CELL( b, x, y )] is the strongest PATTERN_ constant along the four axes
+ * through (x, y) for that color, with the same rules as the solver's threat search: exact fives for
+ * black in renju and overlines ignored. Occupied intersections hold PATTERN_NONE.
+ */
+typedef struct {
+    unsigned char size;
+    unsigned char patterns[2][BOARD_MAX_SIZE * BOARD_MAX_SIZE];
+} threat_map;
+
+/**
+ * Builds the threat map of a position in one pass over the board. The pattern keys of a run of
+ * intersections along a row are computed together, 16 at a time with AVX2 or 8 with SSE2, for all
+ * four axes and both colors; rows and columns too far from every stone are skipped.
+ * The kernel is picked from the processor features the first time, unless threat_use_kernel chose one.
+ * Safe to call from several threads at once.
+ * @param g Reference to the game.
+ * @param map Reference to the location where the map is stored.
+ */
+void threat_scan(const game* g, threat_map* map);
+
+/**
+ * Reads the threat map.
+ * @param map Reference to a map filled by threat_scan.
+ * @param x The horizontal coordinate of the intersection.
+ * @param y The vertical coordinate of the intersection.
+ * @param stone The color of the stone (BLACK_STONE or WHITE_STONE).
+ * @return The PATTERN_ constant a stone of that color would make.
+ */
+unsigned char threat_at(const threat_map* map, unsigned char x, unsigned char y, unsigned char stone);
+
+/**
+ * Tells whether the processor can run a kernel.
+ * @param kernel One of the THREAT_KERNEL_ constants.
+ * @return True if the kernel is compiled in and supported, always for THREAT_KERNEL_SCALAR.
+ */
+bool threat_kernel_supported(unsigned char kernel);
+
+/**
+ * Forces the kernel used by threat_scan, to compare them. Scans already running in other threads finish
+ * with the kernel they started with.
+ * @param kernel One of the THREAT_KERNEL_ constants.
+ * @return False, leaving the kernel unchanged, if the processor cannot run it.
+ */
+bool threat_use_kernel(unsigned char kernel);
+
+/**
+ * Names a kernel.
+ * @param kernel One of the THREAT_KERNEL_ constants.
+ * @return "scalar", "sse2" or "avx2".
+ */
+const char* threat_kernel_name(unsigned char kernel);
+#endif
@@ -0,0 +1,139 @@
+#define _POSIX_C_SOURCE 200809L
+#include "tt.h"
+#include "error-codes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define GENERATION_BITS 0x3F
+
+/**
+ * Packs the data of an entry into 64 bits: score, depth, bound, generation and move.
+ * @param data The data to pack.
+ * @param generation The generation of the search storing the entry.
+ * @return The packed data.
+ */
+static uint64_t pack( const tt_data* data, unsigned char generation );
+
+/**
+ * Unpacks the data of an entry.
+ * @param packed The packed data.
+ * @param data Reference to the location where the unpacked data is stored.
+ */
+static void unpack( uint64_t packed, tt_data* data );
+
+/**
+ * Returns the generation an entry was stored in.
+ * @param packed The packed data of the entry.
+ * @return The generation, from 0 to GENERATION_BITS.
+ */
+static unsigned char generation_of( uint64_t packed );
+
+tt* tt_create( size_t megabytes )
+{
+    tt* table = ( tt * )malloc( sizeof( tt ) );
+    if (table == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    //Largest power of two number of buckets that fits in the budget
+    size_t budget = megabytes * 1024 * 1024 / sizeof( tt_bucket );
+    table->num_buckets = 1;
+    while ( table->num_buckets * 2 <= budget ) {
+        table->num_buckets *= 2;
+    }
+    void* memory;
+    if ( posix_memalign( &memory, TT_CACHE_LINE, table->num_buckets * sizeof( tt_bucket ) ) != 0 ) {
+        fprintf(stderr, "ERROR: Failed to allocate memory\n");
+        exit(1);
+    }
+    table->buckets = ( tt_bucket * )memory;
+    tt_clear( table );
+    return table;
+}
+
+void tt_delete( tt* table )
+{
+    if ( table == NULL ) {
+        exit( NULL_POINTER_ERR );
+    }
+    free( table->buckets );
+    free( table );
+}
+
+void tt_clear( tt* table )
+{
+    memset( table->buckets, 0, table->num_buckets * sizeof( tt_bucket ) );
+    table->generation = 0;
+}
+
+void tt_new_search( tt* table )
+{
+    table->generation = ( table->generation + 1 ) & GENERATION_BITS;
+}
+
+bool tt_probe( const tt* table, uint64_t key, tt_data* data )
+{
+    const tt_bucket* bucket = &table->buckets[ key & ( table->num_buckets - 1 ) ];
+    for ( int i = 0; i < TT_BUCKET_ENTRIES; i++ ) {
+        //Read each word once, atomically since other threads store concurrently; a torn entry fails the check
+        uint64_t packed = __atomic_load_n( &bucket->entries[i].data, __ATOMIC_RELAXED );
+        uint64_t check = __atomic_load_n( &bucket->entries[i].check, __ATOMIC_RELAXED );
+        if ( ( check ^ packed ) == key && packed != 0 ) {
+            unpack( packed, data );
+            return true;
+        }
+    }
+    return false;
+}
+
+void tt_store( tt* table, uint64_t key, const tt_data* data )
+{
+    tt_bucket* bucket = &table->buckets[ key & ( table->num_buckets - 1 ) ];
+    tt_entry* victim = &bucket->entries[0];
+    int victim_value = 1 << 30;
+    for ( int i = 0; i < TT_BUCKET_ENTRIES; i++ ) {
+        tt_entry* entry = &bucket->entries[i];
+        uint64_t packed = __atomic_load_n( &entry->data, __ATOMIC_RELAXED );
+        uint64_t check = __atomic_load_n( &entry->check, __ATOMIC_RELAXED );
+        if ( ( check ^ packed ) == key || packed == 0 ) {
+            victim = entry;
+            break;
+        }
+        //Old entries count as much shallower than entries of the current search
+        tt_data stored;
+        unpack( packed, &stored );
+        int age = ( table->generation - generation_of( packed ) ) & GENERATION_BITS;
+        int value = stored.depth - 8 * age;
+        if ( value < victim_value ) {
+            victim_value = value;
+            victim = entry;
+        }
+    }
+    uint64_t packed = pack( data, table->generation );
+    __atomic_store_n( &victim->data, packed, __ATOMIC_RELAXED );
+    __atomic_store_n( &victim->check, key ^ packed, __ATOMIC_RELAXED );
+}
+
+static uint64_t pack( const tt_data* data, unsigned char generation )
+{
+    return ( uint64_t )( uint32_t ) data->score
+        | ( uint64_t ) data->depth << 32
+        | ( uint64_t )( data->bound & 3 ) << 40
+        | ( uint64_t )( generation & GENERATION_BITS ) << 42
+        | ( uint64_t ) data->x << 48
+        | ( uint64_t ) data->y << 56;
+}
+
+static void unpack( uint64_t packed, tt_data* data )
+{
+    data->score = ( int )( uint32_t ) packed;
+    data->depth = packed >> 32;
+    data->bound = ( packed >> 40 ) & 3;
+    data->x = packed >> 48;
+    data->y = packed >> 56;
+}
+
+static unsigned char generation_of( uint64_t packed )
+{
+    return ( packed >> 42 ) & GENERATION_BITS;
+}
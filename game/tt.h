@@ -0,0 +1,94 @@
+#ifndef _TT_H_
+#define _TT_H_
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#define TT_BOUND_NONE 0
+#define TT_BOUND_EXACT 1
+#define TT_BOUND_LOWER 2
+#define TT_BOUND_UPPER 3
+#define TT_DEFAULT_MB 16
+#define TT_BUCKET_ENTRIES 4
+#define TT_CACHE_LINE 64
+
+/**
+ * One stored position. check is the position key XORed with data, so a probe that reads half of
+ * a concurrent write fails the key comparison instead of returning a mixed entry. Both words are only
+ * read and written with relaxed atomics, so each is whole even while other threads store.
+ */
+typedef struct {
+    uint64_t check;
+    uint64_t data;
+} tt_entry;
+
+/**
+ * The entries sharing one cache line. A key always maps to a single bucket.
+ */
+typedef struct {
+    tt_entry entries[TT_BUCKET_ENTRIES];
+} tt_bucket;
+
+/**
+ * A fixed size table of positions shared by every search thread.
+ */
+typedef struct {
+    tt_bucket* buckets;
+    size_t num_buckets;
+    unsigned char generation;
+} tt;
+
+/**
+ * What the table knows about a position.
+ */
+typedef struct {
+    int score;
+    unsigned char depth;
+    unsigned char bound;
+    unsigned char x;
+    unsigned char y;
+} tt_data;
+
+/**
+ * Allocates an empty table using at most the given amount of memory, rounded down to a power of two
+ * number of cache line aligned buckets. Exits if the memory cannot be allocated.
+ * @param megabytes The memory budget of the table.
+ * @return The newly created table.
+ */
+tt* tt_create(size_t megabytes);
+
+/**
+ * Frees the memory of the table. If the given pointer is null, exits with NULL_POINTER_ERR.
+ * @param table The table to free.
+ */
+void tt_delete(tt* table);
+
+/**
+ * Empties the table.
+ * @param table The table to clear.
+ */
+void tt_clear(tt* table);
+
+/**
+ * Starts a new search, so that entries left by earlier searches are replaced first.
+ * @param table The table used by the search.
+ */
+void tt_new_search(tt* table);
+
+/**
+ * Looks a position up. Safe to call while other threads store into the table.
+ * @param table The table to search.
+ * @param key The Zobrist key of the position.
+ * @param data Reference to the location where the stored data is copied.
+ * @return True if the position was found, false otherwise.
+ */
+bool tt_probe(const tt* table, uint64_t key, tt_data* data);
+
+/**
+ * Stores what a search learned about a position. Replaces the same position if present, otherwise
+ * the shallowest entry of the bucket, preferring entries left by earlier searches.
+ * @param table The table to store into.
+ * @param key The Zobrist key of the position.
+ * @param data The depth, bound, score and best move of the position.
+ */
+void tt_store(tt* table, uint64_t key, const tt_data* data);
+#endif
@@ -0,0 +1,48 @@
+#include "game.h"
+#include "io.h"
+#include "archive.h"
+#include "error-codes.h"
+#include <string.h>
+#define MAX_PATH 4096
+
+/**
+ * Prints out the error message to the console if command line args are not correct.
+ */
+static void arg_error();
+
+/**
+ * Unpacks a binary archive into saved games in the text .gmk format.
+ * The games are written to the given directory as 000001.gmk, 000002.gmk and so on, in archive order.
+ * @param argc The total number of arguments.
+ * @param argv[] Array of arguments
+ * return 0 if successful.
+ */
+int main( int argc, char *argv[] ) {
+    if ( argc != 3 ) {
+        arg_error();
+    }
+    
+    archive* a = archive_open( argv[1] );
+    char path[MAX_PATH];
+    for ( uint32_t i = 0; i < a->count; i++ ) {
+        archive_game ag;
+        unsigned char status = archive_game_at( a, i, &ag );
+        game* g = status == SUCCESS ? archive_load( &ag, &status ) : NULL;
+        if ( g == NULL ) {
+            exit( status );
+        }
+        if ( snprintf( path, MAX_PATH, "%s/%06u.gmk", argv[2], i + 1 ) >= MAX_PATH ) {
+            exit( FILE_OUTPUT_ERR );
+        }
+        game_export( g, path );
+        game_delete( g );
+    }
+    printf( "%u games unpacked into %s\n", a->count, argv[2] );
+    archive_close( a );
+    return 0;
+}
+
+static void arg_error() {
+    printf( "usage: ./unpack <archive.gmb> <directory>\n" );
+    exit( ARGUMENT_ERR );
+}